@@ -0,0 +1,114 @@
+#include "stdlib/time_simulation/time_simulation.h"
+#include "stdlib/math/random.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Hold model benchmark for the event queue engines: n events pending,
+ * each operation pops the earliest and pushes it back at its time plus an
+ * Exp(1) increment, so the queue size stays at n.
+ *
+ *     event_queue_hold [n ...]     (default: 10000 1000000)
+ *
+ * Prints nanoseconds per hold operation for every engine. The sorted list
+ * is O(n) per push and is skipped above LIST_MAX_EVENTS. */
+
+#define LIST_MAX_EVENTS 100000
+#define WARMUP_FACTOR 2            /* Hold operations per event before timing */
+#define MIN_OPERATIONS 2000000
+
+typedef struct EngineInfo {
+    EventQueueEngine engine;
+    const char* name;
+} EngineInfo;
+
+static const EngineInfo engines[] = {
+    {EVENT_QUEUE_SORTED_LIST, "list"},
+    {EVENT_QUEUE_BINARY_HEAP, "binary"},
+    {EVENT_QUEUE_QUATERNARY_HEAP, "4-ary"},
+    {EVENT_QUEUE_PAIRING_HEAP, "pairing"},
+    {EVENT_QUEUE_CALENDAR, "calendar"},
+};
+
+static double elapsed_ns(const struct timespec* start, const struct timespec* end) {
+    return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+static void hold(EventQueue* queue, Random* rng, long operations) {
+    for (long i = 0; i < operations; i++) {
+        Event* event = event_queue_next(queue);
+        event->time += sim_time_from_double(random_exponential(rng, 1.0));
+        event_queue_schedule(queue, event);
+    }
+}
+
+/* Nanoseconds per hold operation, or a negative value on failure */
+static double run_engine(EventQueueEngine engine, int n) {
+    EventQueue* queue = event_queue_create_with_engine(engine);
+    if (queue == NULL) {
+        return -1.0;
+    }
+
+    /* The queue owns scheduled events and frees them when destroyed */
+    Random rng;
+    random_init(&rng, 12345);
+    for (int i = 0; i < n; i++) {
+        Event* event = event_create(sim_time_from_double(random_exponential(&rng, 1.0)),
+                                    EVENT_CUSTOM, NULL, NULL);
+        if (event == NULL) {
+            event_queue_destroy(queue);
+            return -1.0;
+        }
+        event_queue_schedule(queue, event);
+    }
+
+    hold(queue, &rng, (long)n * WARMUP_FACTOR);
+
+    long operations = n > MIN_OPERATIONS ? n : MIN_OPERATIONS;
+    if (engine == EVENT_QUEUE_SORTED_LIST) {
+        operations = n * 10L;  /* O(n) per operation */
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    hold(queue, &rng, operations);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    event_queue_destroy(queue);
+    return elapsed_ns(&start, &end) / (double)operations;
+}
+
+int main(int argc, char** argv) {
+    int default_sizes[] = {10000, 1000000};
+    int size_count = argc > 1 ? argc - 1 : 2;
+
+    printf("%10s", "n");
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        printf(" %10s", engines[e].name);
+    }
+    printf("   (ns per hold)\n");
+
+    for (int s = 0; s < size_count; s++) {
+        int n = argc > 1 ? atoi(argv[s + 1]) : default_sizes[s];
+        if (n <= 0) {
+            fprintf(stderr, "invalid size: %s\n", argv[s + 1]);
+            return 1;
+        }
+
+        printf("%10d", n);
+        for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+            if (engines[e].engine == EVENT_QUEUE_SORTED_LIST && n > LIST_MAX_EVENTS) {
+                printf(" %10s", "-");
+                continue;
+            }
+            double ns = run_engine(engines[e].engine, n);
+            if (ns < 0.0) {
+                printf(" %10s", "failed");
+            } else {
+                printf(" %10.1f", ns);
+            }
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -2,6 +2,7 @@
 #include "../frontend/symbol_table.h"
 #include "../debug/debug.h"
 #include "../debug/debug_runtime.h"
+#include "../stdlib/math/random.h"
 #include <llvm-c/Core.h>
 #include <llvm-c/Analysis.h>
 #include <llvm-c/Target.h>
@@ -22,6 +23,9 @@ struct CodeGenerator {
     // JIT 执行相关
     LLVMExecutionEngineRef execution_engine;
     int jit_initialized;
+    // 缓冲随机流: 每个函数入口取一次本线程的流指针
+    LLVMValueRef random_stream_function;
+    LLVMValueRef random_streams[RANDOM_STREAM_NORMAL + 1];
 };
 
 /* 辅助函数：记录变量值 */
@@ -179,6 +183,8 @@ CodeGenerator* codegen_create_with_debug(const char* module_name, DebugContext*
     codegen->debug_ctx = debug_ctx;
     codegen->execution_engine = NULL;
     codegen->jit_initialized = 0;
+    codegen->random_stream_function = NULL;
+    memset(codegen->random_streams, 0, sizeof(codegen->random_streams));
     
     // 如果有调试上下文，声明调试运行时函数
     if (debug_ctx) {
@@ -336,6 +342,101 @@ static DataType infer_type_from_llvm_value(CodeGenerator* codegen, LLVMValueRef
     }
 }
 
+/* RandomStream 的前两个字段 (next, end)，内联快速路径只访问它们 */
+static LLVMTypeRef random_stream_head_type(CodeGenerator* codegen) {
+    LLVMTypeRef double_ptr = LLVMPointerType(LLVMDoubleTypeInContext(codegen->context), 0);
+    LLVMTypeRef field_types[] = {double_ptr, double_ptr};
+    return LLVMStructTypeInContext(codegen->context, field_types, 2, 0);
+}
+
+/* 当前函数中某类缓冲随机流的指针: 在入口块调用一次 random_stream_global 并缓存 */
+static LLVMValueRef codegen_random_stream(CodeGenerator* codegen, RandomStreamKind kind) {
+    if (codegen->random_stream_function != codegen->current_function) {
+        codegen->random_stream_function = codegen->current_function;
+        memset(codegen->random_streams, 0, sizeof(codegen->random_streams));
+    }
+    if (codegen->random_streams[kind]) {
+        return codegen->random_streams[kind];
+    }
+
+    LLVMTypeRef stream_ptr = LLVMPointerType(random_stream_head_type(codegen), 0);
+    LLVMTypeRef param_types[] = {LLVMInt32TypeInContext(codegen->context)};
+    LLVMTypeRef func_type = LLVMFunctionType(stream_ptr, param_types, 1, 0);
+    LLVMValueRef func = LLVMGetNamedFunction(codegen->module, "random_stream_global");
+    if (!func) {
+        func = LLVMAddFunction(codegen->module, "random_stream_global", func_type);
+    }
+
+    // 插入到入口块开头，使流指针支配函数内所有使用点
+    LLVMBasicBlockRef entry = LLVMGetEntryBasicBlock(codegen->current_function);
+    LLVMValueRef first = LLVMGetFirstInstruction(entry);
+    LLVMBuilderRef entry_builder = LLVMCreateBuilderInContext(codegen->context);
+    if (first) {
+        LLVMPositionBuilderBefore(entry_builder, first);
+    } else {
+        LLVMPositionBuilderAtEnd(entry_builder, entry);
+    }
+    LLVMValueRef args[] = {LLVMConstInt(LLVMInt32TypeInContext(codegen->context), kind, 0)};
+    LLVMValueRef stream = LLVMBuildCall2(entry_builder, func_type, func, args, 1, "random_stream");
+    LLVMDisposeBuilder(entry_builder);
+
+    codegen->random_streams[kind] = stream;
+    return stream;
+}
+
+/* 从缓冲随机流取一个单位随机数: 缓冲非空时只是指针递增，耗尽时才调用 random_stream_refill */
+static LLVMValueRef codegen_random_stream_draw(CodeGenerator* codegen, RandomStreamKind kind) {
+    LLVMTypeRef double_type = LLVMDoubleTypeInContext(codegen->context);
+    LLVMTypeRef double_ptr = LLVMPointerType(double_type, 0);
+    LLVMTypeRef head_type = random_stream_head_type(codegen);
+    LLVMValueRef stream = codegen_random_stream(codegen, kind);
+
+    LLVMValueRef next_addr = LLVMBuildStructGEP2(codegen->builder, head_type, stream, 0, "stream_next_addr");
+    LLVMValueRef end_addr = LLVMBuildStructGEP2(codegen->builder, head_type, stream, 1, "stream_end_addr");
+    LLVMValueRef next = LLVMBuildLoad2(codegen->builder, double_ptr, next_addr, "stream_next");
+    LLVMValueRef end = LLVMBuildLoad2(codegen->builder, double_ptr, end_addr, "stream_end");
+    LLVMValueRef ready = LLVMBuildICmp(codegen->builder, LLVMIntNE, next, end, "stream_ready");
+
+    LLVMBasicBlockRef fast_block = LLVMAppendBasicBlockInContext(codegen->context, codegen->current_function, "stream_fast");
+    LLVMBasicBlockRef refill_block = LLVMAppendBasicBlockInContext(codegen->context, codegen->current_function, "stream_refill");
+    LLVMBasicBlockRef merge_block = LLVMAppendBasicBlockInContext(codegen->context, codegen->current_function, "stream_merge");
+    LLVMBuildCondBr(codegen->builder, ready, fast_block, refill_block);
+
+    // 快速路径: *next++
+    LLVMPositionBuilderAtEnd(codegen->builder, fast_block);
+    LLVMValueRef fast_value = LLVMBuildLoad2(codegen->builder, double_type, next, "stream_value");
+    LLVMValueRef one = LLVMConstInt(LLVMInt64TypeInContext(codegen->context), 1, 0);
+    LLVMValueRef advanced = LLVMBuildGEP2(codegen->builder, double_type, next, &one, 1, "stream_advance");
+    LLVMBuildStore(codegen->builder, advanced, next_addr);
+    LLVMBuildBr(codegen->builder, merge_block);
+
+    // 慢速路径: 重新填充缓冲区
+    LLVMPositionBuilderAtEnd(codegen->builder, refill_block);
+    LLVMTypeRef refill_params[] = {LLVMPointerType(head_type, 0)};
+    LLVMTypeRef refill_type = LLVMFunctionType(double_type, refill_params, 1, 0);
+    LLVMValueRef refill = LLVMGetNamedFunction(codegen->module, "random_stream_refill");
+    if (!refill) {
+        refill = LLVMAddFunction(codegen->module, "random_stream_refill", refill_type);
+    }
+    LLVMValueRef refill_value = LLVMBuildCall2(codegen->builder, refill_type, refill, &stream, 1, "stream_refilled");
+    LLVMBuildBr(codegen->builder, merge_block);
+
+    LLVMPositionBuilderAtEnd(codegen->builder, merge_block);
+    LLVMValueRef value = LLVMBuildPhi(codegen->builder, double_type, "stream_draw");
+    LLVMValueRef incoming_values[] = {fast_value, refill_value};
+    LLVMBasicBlockRef incoming_blocks[] = {fast_block, refill_block};
+    LLVMAddIncoming(value, incoming_values, incoming_blocks, 2);
+    return value;
+}
+
+/* 随机分布参数按实数传递 */
+static LLVMValueRef codegen_to_double(CodeGenerator* codegen, LLVMValueRef value) {
+    if (LLVMGetTypeKind(LLVMTypeOf(value)) == LLVMIntegerTypeKind) {
+        return LLVMBuildSIToFP(codegen->builder, value, LLVMDoubleTypeInContext(codegen->context), "to_real");
+    }
+    return value;
+}
+
 /* 生成表达式 */
 static LLVMValueRef codegen_expression(CodeGenerator* codegen, ASTNode* node) {
     if (!node) return NULL;
@@ -556,15 +657,26 @@ static LLVMValueRef codegen_expression(CodeGenerator* codegen, ASTNode* node) {
             LLVMValueRef result = NULL;
 
             if (strcmp(func_name, "random") == 0) {
-                // random_uniform_global()
-                LLVMValueRef func = LLVMGetNamedFunction(codegen->module, "random_uniform_global");
-                if (!func) {
-                    // 声明外部函数
-                    LLVMTypeRef ret_type = LLVMDoubleTypeInContext(codegen->context);
-                    LLVMTypeRef func_type = LLVMFunctionType(ret_type, NULL, 0, 0);
-                    func = LLVMAddFunction(codegen->module, "random_uniform_global", func_type);
-                }
-                result = LLVMBuildCall2(codegen->builder, LLVMGetElementType(LLVMTypeOf(func)), func, NULL, 0, "random");
+                // 内联快速路径: 本线程的均匀分布缓冲流
+                result = codegen_random_stream_draw(codegen, RANDOM_STREAM_UNIFORM);
+            }
+            else if (strcmp(func_name, "exponential") == 0 && arg_count == 1) {
+                // 单位指数随机数除以速率；速率非正时为 0，与 random_exponential 一致
+                LLVMTypeRef double_type = LLVMDoubleTypeInContext(codegen->context);
+                LLVMValueRef rate = codegen_to_double(codegen, args[0]);
+                LLVMValueRef draw = codegen_random_stream_draw(codegen, RANDOM_STREAM_EXPONENTIAL);
+                LLVMValueRef scaled = LLVMBuildFDiv(codegen->builder, draw, rate, "exponential");
+                LLVMValueRef zero = LLVMConstReal(double_type, 0.0);
+                LLVMValueRef positive = LLVMBuildFCmp(codegen->builder, LLVMRealOGT, rate, zero, "rate_positive");
+                result = LLVMBuildSelect(codegen->builder, positive, scaled, zero, "exponential");
+            }
+            else if (strcmp(func_name, "normal") == 0 && arg_count == 2) {
+                // mean + z * stddev，z 取自标准正态缓冲流
+                LLVMValueRef mean = codegen_to_double(codegen, args[0]);
+                LLVMValueRef stddev = codegen_to_double(codegen, args[1]);
+                LLVMValueRef draw = codegen_random_stream_draw(codegen, RANDOM_STREAM_NORMAL);
+                LLVMValueRef scaled = LLVMBuildFMul(codegen->builder, draw, stddev, "normal_scaled");
+                result = LLVMBuildFAdd(codegen->builder, mean, scaled, "normal");
             }
             else if (strcmp(func_name, "uniform") == 0 && arg_count == 2) {
                 // random_uniform_int_global(min, max)
@@ -577,28 +689,6 @@ static LLVMValueRef codegen_expression(CodeGenerator* codegen, ASTNode* node) {
                 }
                 result = LLVMBuildCall2(codegen->builder, LLVMGetElementType(LLVMTypeOf(func)), func, args, arg_count, "uniform");
             }
-            else if (strcmp(func_name, "normal") == 0 && arg_count == 2) {
-                // random_normal_global(mean, stddev)
-                LLVMValueRef func = LLVMGetNamedFunction(codegen->module, "random_normal_global");
-                if (!func) {
-                    LLVMTypeRef param_types[2] = {LLVMDoubleTypeInContext(codegen->context), LLVMDoubleTypeInContext(codegen->context)};
-                    LLVMTypeRef ret_type = LLVMDoubleTypeInContext(codegen->context);
-                    LLVMTypeRef func_type = LLVMFunctionType(ret_type, param_types, 2, 0);
-                    func = LLVMAddFunction(codegen->module, "random_normal_global", func_type);
-                }
-                result = LLVMBuildCall2(codegen->builder, LLVMGetElementType(LLVMTypeOf(func)), func, args, arg_count, "normal");
-            }
-            else if (strcmp(func_name, "exponential") == 0 && arg_count == 1) {
-                // random_exponential_global(rate)
-                LLVMValueRef func = LLVMGetNamedFunction(codegen->module, "random_exponential_global");
-                if (!func) {
-                    LLVMTypeRef param_types[1] = {LLVMDoubleTypeInContext(codegen->context)};
-                    LLVMTypeRef ret_type = LLVMDoubleTypeInContext(codegen->context);
-                    LLVMTypeRef func_type = LLVMFunctionType(ret_type, param_types, 1, 0);
-                    func = LLVMAddFunction(codegen->module, "random_exponential_global", func_type);
-                }
-                result = LLVMBuildCall2(codegen->builder, LLVMGetElementType(LLVMTypeOf(func)), func, args, arg_count, "exponential");
-            }
             else if (strcmp(func_name, "poisson") == 0 && arg_count == 1) {
                 // random_poisson_global(lambda)
                 LLVMValueRef func = LLVMGetNamedFunction(codegen->module, "random_poisson_global");
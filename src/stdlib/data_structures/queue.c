@@ -56,6 +56,7 @@ Queue* queue_create(int capacity, void (*free_element)(void*)) {
     queue->count = 0;
     queue->capacity = capacity;
     queue->free_element = free_element;
+    time_weighted_init(&queue->length_stat, sim_time_now(), 0.0);
 
     return queue;
 }
@@ -66,6 +67,7 @@ void queue_destroy(Queue* queue) {
     }
 
     queue_clear(queue);
+    time_weighted_unbind(&queue->length_stat);
     free(queue->elements);
     free(queue);
 }
@@ -82,6 +84,7 @@ bool queue_enqueue(Queue* queue, void* element) {
     queue->elements[queue->rear] = element;
     queue->rear = (queue->rear + 1) % queue->capacity;
     queue->count++;
+    time_weighted_set_now(&queue->length_stat, queue->count);
 
     return true;
 }
@@ -94,6 +97,7 @@ void* queue_dequeue(Queue* queue) {
     void* element = queue->elements[queue->front];
     queue->front = (queue->front + 1) % queue->capacity;
     queue->count--;
+    time_weighted_set_now(&queue->length_stat, queue->count);
 
     return element;
 }
@@ -133,6 +137,25 @@ void queue_clear(Queue* queue) {
     queue->front = 0;
     queue->rear = 0;
     queue->count = 0;
+    time_weighted_set_now(&queue->length_stat, 0.0);
+}
+
+double queue_get_average_length(Queue* queue) {
+    return (queue != NULL) ? time_weighted_mean_now(&queue->length_stat) : 0.0;
+}
+
+void queue_set_simulator(Queue* queue, Simulator* sim) {
+    if (queue != NULL) {
+        time_weighted_bind_simulator(&queue->length_stat, sim);
+    }
+}
+
+int queue_get_min_length(Queue* queue) {
+    return (queue != NULL) ? (int)time_weighted_min(&queue->length_stat) : 0;
+}
+
+int queue_get_max_length(Queue* queue) {
+    return (queue != NULL) ? (int)time_weighted_max(&queue->length_stat) : 0;
 }
 
 void* queue_get_at(Queue* queue, int index) {
@@ -5,6 +5,7 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include "../time_simulation/time_simulation.h"
 
 /* Queue data structure for SIMSCRIPT */
 typedef struct Queue {
@@ -14,6 +15,7 @@ typedef struct Queue {
     int count;
     int capacity;
     void (*free_element)(void*);  /* Element cleanup function */
+    TimeWeightedStat length_stat; /* Length over simulated time */
 } Queue;
 
 /* Create a new queue */
@@ -43,6 +45,19 @@ int queue_size(Queue* queue);
 /* Clear all elements from the queue */
 void queue_clear(Queue* queue);
 
+/* Measure length against sim's clock from its current time on. A queue
+ * used inside a run binds to that simulator by itself; bind explicitly to
+ * query one that only changes outside runs. Destroying the simulator
+ * drops the binding, so a queue reused across replications follows the
+ * next simulator. */
+void queue_set_simulator(Queue* queue, Simulator* sim);
+
+/* Time-average, minimum and maximum length since creation (or binding),
+ * up to the simulator's current time */
+double queue_get_average_length(Queue* queue);
+int queue_get_min_length(Queue* queue);
+int queue_get_max_length(Queue* queue);
+
 /* Get element at specific index (for iteration) */
 void* queue_get_at(Queue* queue, int index);
 
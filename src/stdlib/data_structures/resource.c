@@ -24,6 +24,19 @@ Resource* resource_create(const char* name, int total_units) {
     resource->available_units = total_units;
     resource->busy_units = 0;
     resource->user_data = NULL;
+    resource->discipline = RESOURCE_FIFO;
+    resource->wait_heap = NULL;
+    resource->waiting = 0;
+    resource->wait_capacity = 0;
+    resource->holders = NULL;
+    resource->holder_count = 0;
+    resource->holder_capacity = 0;
+    resource->next_sequence = 0;
+    resource->preempted_sequence = -1;
+    resource->total_waits = 0;
+    resource->preemptions = 0;
+    time_weighted_init(&resource->busy_stat, sim_time_now(), 0.0);
+    time_weighted_init(&resource->waiting_stat, sim_time_now(), 0.0);
 
     return resource;
 }
@@ -33,6 +46,10 @@ void resource_destroy(Resource* resource) {
         return;
     }
 
+    time_weighted_unbind(&resource->busy_stat);
+    time_weighted_unbind(&resource->waiting_stat);
+    free(resource->wait_heap);
+    free(resource->holders);
     free(resource->name);
     free(resource);
 }
@@ -48,10 +65,305 @@ int resource_request(Resource* resource, int requested_units) {
 
     resource->available_units -= requested_units;
     resource->busy_units += requested_units;
+    time_weighted_set_now(&resource->busy_stat, resource->busy_units);
 
     return requested_units;
 }
 
+/* Wait heap: the root is the next waiter to serve */
+static bool waiter_before(const Resource* resource, const ResourceWaiter* a,
+                          const ResourceWaiter* b) {
+    if (resource->discipline != RESOURCE_FIFO && a->priority != b->priority) {
+        return a->priority > b->priority;
+    }
+    return a->sequence < b->sequence;
+}
+
+static void heap_place(Resource* resource, ResourceWaiter* waiter, int index) {
+    resource->wait_heap[index] = waiter;
+    waiter->index = index;
+}
+
+static void heap_sift_up(Resource* resource, int index) {
+    ResourceWaiter* waiter = resource->wait_heap[index];
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!waiter_before(resource, waiter, resource->wait_heap[parent])) {
+            break;
+        }
+        heap_place(resource, resource->wait_heap[parent], index);
+        index = parent;
+    }
+    heap_place(resource, waiter, index);
+}
+
+static void heap_sift_down(Resource* resource, int index) {
+    ResourceWaiter* waiter = resource->wait_heap[index];
+    for (;;) {
+        int child = 2 * index + 1;
+        if (child >= resource->waiting) {
+            break;
+        }
+        if (child + 1 < resource->waiting &&
+            waiter_before(resource, resource->wait_heap[child + 1], resource->wait_heap[child])) {
+            child++;
+        }
+        if (!waiter_before(resource, resource->wait_heap[child], waiter)) {
+            break;
+        }
+        heap_place(resource, resource->wait_heap[child], index);
+        index = child;
+    }
+    heap_place(resource, waiter, index);
+}
+
+/* Room for slots waiters in the heap without further allocation */
+static bool heap_reserve(Resource* resource, int slots) {
+    if (slots <= resource->wait_capacity) {
+        return true;
+    }
+
+    int capacity = resource->wait_capacity > 0 ? resource->wait_capacity : 16;
+    while (capacity < slots) {
+        capacity *= 2;
+    }
+    ResourceWaiter** heap = (ResourceWaiter**)realloc(
+        resource->wait_heap, (size_t)capacity * sizeof(ResourceWaiter*));
+    if (heap == NULL) {
+        return false;
+    }
+    resource->wait_heap = heap;
+    resource->wait_capacity = capacity;
+    return true;
+}
+
+/* The caller has reserved the slot */
+static void heap_push(Resource* resource, ResourceWaiter* waiter) {
+    resource->wait_heap[resource->waiting] = waiter;
+    resource->waiting++;
+    heap_sift_up(resource, resource->waiting - 1);
+    time_weighted_set_now(&resource->waiting_stat, resource->waiting);
+}
+
+static void heap_remove(Resource* resource, int index) {
+    ResourceWaiter* removed = resource->wait_heap[index];
+    resource->waiting--;
+    if (index < resource->waiting) {
+        resource->wait_heap[index] = resource->wait_heap[resource->waiting];
+        heap_sift_down(resource, index);
+        heap_sift_up(resource, resource->wait_heap[index]->index);
+    }
+    removed->index = -1;
+    time_weighted_set_now(&resource->waiting_stat, resource->waiting);
+}
+
+/* Holders that may be preempted, in a binary heap whose root is the next
+ * victim: lowest priority, then most recently granted */
+static bool holder_before(const ResourceWaiter* a, const ResourceWaiter* b) {
+    if (a->priority != b->priority) {
+        return a->priority < b->priority;
+    }
+    return a->sequence > b->sequence;
+}
+
+static void holder_place(Resource* resource, ResourceWaiter* waiter, int index) {
+    resource->holders[index] = waiter;
+    waiter->index = index;
+}
+
+static void holder_sift_up(Resource* resource, int index) {
+    ResourceWaiter* waiter = resource->holders[index];
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!holder_before(waiter, resource->holders[parent])) {
+            break;
+        }
+        holder_place(resource, resource->holders[parent], index);
+        index = parent;
+    }
+    holder_place(resource, waiter, index);
+}
+
+static void holder_sift_down(Resource* resource, int index) {
+    ResourceWaiter* waiter = resource->holders[index];
+    for (;;) {
+        int child = 2 * index + 1;
+        if (child >= resource->holder_count) {
+            break;
+        }
+        if (child + 1 < resource->holder_count &&
+            holder_before(resource->holders[child + 1], resource->holders[child])) {
+            child++;
+        }
+        if (!holder_before(resource->holders[child], waiter)) {
+            break;
+        }
+        holder_place(resource, resource->holders[child], index);
+        index = child;
+    }
+    holder_place(resource, waiter, index);
+}
+
+static void holder_add(Resource* resource, ResourceWaiter* waiter) {
+    if (resource->discipline != RESOURCE_PREEMPTIVE || waiter->preempt == NULL) {
+        return;
+    }
+
+    if (resource->holder_count == resource->holder_capacity) {
+        int capacity = resource->holder_capacity > 0 ? resource->holder_capacity * 2 : 8;
+        ResourceWaiter** holders = (ResourceWaiter**)realloc(
+            resource->holders, (size_t)capacity * sizeof(ResourceWaiter*));
+        if (holders == NULL) {
+            return;  /* Holds on, just cannot be preempted */
+        }
+        resource->holders = holders;
+        resource->holder_capacity = capacity;
+    }
+
+    waiter->holding = true;
+    resource->holders[resource->holder_count++] = waiter;
+    holder_sift_up(resource, resource->holder_count - 1);
+}
+
+static void holder_remove(Resource* resource, ResourceWaiter* waiter) {
+    int index = waiter->index;
+    int last = --resource->holder_count;
+    if (index < last) {
+        resource->holders[index] = resource->holders[last];
+        holder_sift_down(resource, index);
+        holder_sift_up(resource, resource->holders[index]->index);
+    }
+    waiter->index = -1;
+    waiter->holding = false;
+}
+
+/* Units held below priority in the subtree at index, adding up only until
+ * need is reached; children never rank below their parent, so the walk
+ * stops at the first holder of priority or more on every path */
+static int holder_reclaimable(const Resource* resource, int index, int priority, int need) {
+    if (index >= resource->holder_count || resource->holders[index]->priority >= priority) {
+        return 0;
+    }
+    int units = resource->holders[index]->units;
+    if (units < need) {
+        units += holder_reclaimable(resource, 2 * index + 1, priority, need - units);
+    }
+    if (units < need) {
+        units += holder_reclaimable(resource, 2 * index + 2, priority, need - units);
+    }
+    return units;
+}
+
+/* Serve waiters from the root while they fit */
+static void resource_dispatch(Resource* resource) {
+    while (resource->waiting > 0 &&
+           resource->wait_heap[0]->units <= resource->available_units) {
+        ResourceWaiter* waiter = resource->wait_heap[0];
+        heap_remove(resource, 0);
+        resource_request(resource, waiter->units);
+        holder_add(resource, waiter);
+        waiter->grant(waiter);
+    }
+}
+
+/* Take units back from lower priority holders if that makes the request
+ * fit; the lowest priority, most recently granted holders go first. Each
+ * holder visited before deciding contributes a unit or more, so deciding
+ * costs O(units short) and each victim O(log holders). The caller has
+ * reserved a wait slot for every holder, so each victim is queued again. */
+static bool resource_preempt_for(Resource* resource, const ResourceWaiter* requester) {
+    int need = requester->units - resource->available_units;
+    if (holder_reclaimable(resource, 0, requester->priority, need) < need) {
+        return false;
+    }
+
+    while (resource->available_units < requester->units) {
+        ResourceWaiter* victim = resource->holders[0];
+        holder_remove(resource, victim);
+        resource->busy_units -= victim->units;
+        resource->available_units += victim->units;
+        resource->preemptions++;
+
+        /* Ahead of every waiter of its priority that was never served */
+        victim->sequence = resource->preempted_sequence--;
+        heap_push(resource, victim);
+        victim->preempt(victim);
+    }
+    time_weighted_set_now(&resource->busy_stat, resource->busy_units);
+    return true;
+}
+
+bool resource_set_discipline(Resource* resource, ResourceDiscipline discipline) {
+    if (resource == NULL || resource->waiting > 0 || resource->holder_count > 0) {
+        return false;
+    }
+    resource->discipline = discipline;
+    return true;
+}
+
+ResourceRequestResult resource_request_or_wait(Resource* resource, ResourceWaiter* waiter,
+                                               int units) {
+    if (resource == NULL || waiter == NULL || waiter->grant == NULL ||
+        units <= 0 || units > resource->total_units) {
+        return RESOURCE_REJECTED;
+    }
+
+    waiter->units = units;
+    waiter->sequence = resource->next_sequence++;
+    waiter->index = -1;
+    waiter->holding = false;
+    waiter->resource = resource;
+
+    /* Served now only if no queued waiter ranks ahead of it */
+    bool first = resource->waiting == 0 ||
+                 waiter_before(resource, waiter, resource->wait_heap[0]);
+    if (first) {
+        if (resource->available_units < units && resource->discipline == RESOURCE_PREEMPTIVE) {
+            /* Every victim, and the requester if it still does not fit,
+             * must be queued; reserve before taking any units */
+            if (!heap_reserve(resource, resource->waiting + resource->holder_count + 1)) {
+                waiter->resource = NULL;
+                return RESOURCE_REJECTED;
+            }
+            resource_preempt_for(resource, waiter);
+        }
+        if (resource->available_units >= units) {
+            resource_request(resource, units);
+            holder_add(resource, waiter);
+            return RESOURCE_GRANTED;
+        }
+    }
+
+    if (!heap_reserve(resource, resource->waiting + 1)) {
+        waiter->resource = NULL;
+        return RESOURCE_REJECTED;
+    }
+    resource->total_waits++;
+    heap_push(resource, waiter);
+    return RESOURCE_QUEUED;
+}
+
+bool resource_cancel_wait(Resource* resource, ResourceWaiter* waiter) {
+    if (resource == NULL || waiter == NULL || waiter->holding || waiter->index < 0 ||
+        waiter->index >= resource->waiting || resource->wait_heap[waiter->index] != waiter) {
+        return false;
+    }
+
+    heap_remove(resource, waiter->index);
+    waiter->resource = NULL;
+    /* A large head waiter leaving may let smaller ones through */
+    resource_dispatch(resource);
+    return true;
+}
+
+int resource_get_waiting(Resource* resource) {
+    return (resource != NULL) ? resource->waiting : 0;
+}
+
+double resource_get_average_waiting(Resource* resource) {
+    return (resource != NULL) ? time_weighted_mean_now(&resource->waiting_stat) : 0.0;
+}
+
 bool resource_release(Resource* resource, int units_to_release) {
     if (resource == NULL || units_to_release <= 0) {
         return false;
@@ -63,10 +375,29 @@ bool resource_release(Resource* resource, int units_to_release) {
 
     resource->busy_units -= units_to_release;
     resource->available_units += units_to_release;
+    time_weighted_set_now(&resource->busy_stat, resource->busy_units);
 
+    resource_dispatch(resource);
     return true;
 }
 
+bool resource_release_waiter(Resource* resource, ResourceWaiter* waiter) {
+    if (resource == NULL || waiter == NULL || waiter->resource != resource ||
+        (!waiter->holding && waiter->index >= 0)) {
+        return false;  /* Not granted, still queued */
+    }
+
+    resource_untrack_holder(resource, waiter);
+    waiter->resource = NULL;
+    return resource_release(resource, waiter->units);
+}
+
+void resource_untrack_holder(Resource* resource, ResourceWaiter* waiter) {
+    if (resource != NULL && waiter != NULL && waiter->holding) {
+        holder_remove(resource, waiter);
+    }
+}
+
 const char* resource_get_name(Resource* resource) {
     return (resource != NULL) ? resource->name : NULL;
 }
@@ -99,13 +430,45 @@ double resource_get_utilization(Resource* resource) {
     return (double)resource->busy_units / (double)resource->total_units;
 }
 
+void resource_set_simulator(Resource* resource, Simulator* sim) {
+    if (resource != NULL) {
+        time_weighted_bind_simulator(&resource->busy_stat, sim);
+        time_weighted_bind_simulator(&resource->waiting_stat, sim);
+    }
+}
+
+double resource_get_average_busy_units(Resource* resource) {
+    return (resource != NULL) ? time_weighted_mean_now(&resource->busy_stat) : 0.0;
+}
+
+double resource_get_average_utilization(Resource* resource) {
+    if (resource == NULL || resource->total_units == 0) {
+        return 0.0;
+    }
+
+    return time_weighted_mean_now(&resource->busy_stat) / (double)resource->total_units;
+}
+
 void resource_reset(Resource* resource) {
     if (resource == NULL) {
         return;
     }
 
+    /* Holders lose their units without being preempted */
+    while (resource->holder_count > 0) {
+        ResourceWaiter* holder = resource->holders[resource->holder_count - 1];
+        holder_remove(resource, holder);
+        holder->resource = NULL;
+    }
     resource->available_units = resource->total_units;
     resource->busy_units = 0;
+    resource->busy_stat.value = 0.0;
+    resource->waiting_stat.value = resource->waiting;
+    /* A binding whose simulator was destroyed is already gone, so the
+     * stats rebind to the next simulator that uses the resource */
+    time_weighted_restart(&resource->busy_stat);
+    time_weighted_restart(&resource->waiting_stat);
+    resource_dispatch(resource);
 }
 
 void resource_set_user_data(Resource* resource, void* user_data) {
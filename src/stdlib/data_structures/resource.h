@@ -5,6 +5,42 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include "../time_simulation/time_simulation.h"
+
+/* Order in which blocked requesters are served. PRIORITY serves higher
+ * priority first; PREEMPTIVE additionally takes units from lower priority
+ * holders that can be preempted when a request does not fit. Equal
+ * priorities are served first come, first served. */
+typedef enum {
+    RESOURCE_FIFO,
+    RESOURCE_PRIORITY,
+    RESOURCE_PREEMPTIVE
+} ResourceDiscipline;
+
+/* Outcome of resource_request_or_wait */
+typedef enum {
+    RESOURCE_GRANTED,          /* Units allocated now */
+    RESOURCE_QUEUED,           /* Waiter queued; grant runs once it is served */
+    RESOURCE_REJECTED          /* Neither: invalid request, or no memory to queue it */
+} ResourceRequestResult;
+
+struct Resource;
+
+/* A requester, embedded in its owner so waiting allocates nothing. Set
+ * priority, grant and (for preemption) preempt before requesting; grant
+ * runs once queued units have been allocated to the waiter, preempt after
+ * its units were taken back and it was queued again. A waiter without
+ * preempt is never preempted. */
+typedef struct ResourceWaiter {
+    int units;
+    int priority;              /* Higher is served first */
+    int64_t sequence;          /* Arrival order within a priority */
+    int index;                 /* Position in the wait or holder heap, -1 in neither */
+    bool holding;              /* Granted and tracked for preemption */
+    struct Resource* resource; /* Resource queued on or held from */
+    void (*grant)(struct ResourceWaiter* waiter);
+    void (*preempt)(struct ResourceWaiter* waiter);
+} ResourceWaiter;
 
 /* Resource data structure for SIMSCRIPT simulation */
 typedef struct Resource {
@@ -13,6 +49,19 @@ typedef struct Resource {
     int available_units;  /* Currently available units */
     int busy_units;       /* Units currently in use */
     void* user_data;      /* Optional user data */
+    TimeWeightedStat busy_stat;     /* Busy units over simulated time */
+    TimeWeightedStat waiting_stat;  /* Blocked requesters over simulated time */
+    ResourceDiscipline discipline;
+    ResourceWaiter** wait_heap;     /* Binary heap of blocked requesters */
+    int waiting;
+    int wait_capacity;
+    ResourceWaiter** holders;       /* Heap of preemptible holders (PREEMPTIVE only) */
+    int holder_count;
+    int holder_capacity;
+    int64_t next_sequence;
+    int64_t preempted_sequence;     /* Counts down so preempted waiters go first */
+    uint64_t total_waits;           /* Requests that had to wait */
+    uint64_t preemptions;
 } Resource;
 
 /* Create a new resource */
@@ -24,9 +73,32 @@ void resource_destroy(Resource* resource);
 /* Request resource units (returns number of units allocated, 0 if none available) */
 int resource_request(Resource* resource, int requested_units);
 
-/* Release resource units */
+/* Choose the wait discipline; only while nobody is waiting or holding */
+bool resource_set_discipline(Resource* resource, ResourceDiscipline discipline);
+
+/* Allocate units now or queue waiter, O(log n). Requests for no units or
+ * more than total_units, and requests the wait queue has no room for, are
+ * rejected; a rejected request preempts nobody. */
+ResourceRequestResult resource_request_or_wait(Resource* resource, ResourceWaiter* waiter,
+                                               int units);
+
+/* Remove a waiter that has not been granted yet, O(log n) */
+bool resource_cancel_wait(Resource* resource, ResourceWaiter* waiter);
+
+/* Number of blocked requesters, and its time average */
+int resource_get_waiting(Resource* resource);
+double resource_get_average_waiting(Resource* resource);
+
+/* Release resource units, granting them to waiters that now fit. The head
+ * waiter blocks the ones behind it until it fits. */
 bool resource_release(Resource* resource, int units_to_release);
 
+/* Release everything a waiter holds and stop tracking it */
+bool resource_release_waiter(Resource* resource, ResourceWaiter* waiter);
+
+/* Stop tracking a holder for preemption; it keeps its units */
+void resource_untrack_holder(Resource* resource, ResourceWaiter* waiter);
+
 /* Get resource name */
 const char* resource_get_name(Resource* resource);
 
@@ -45,6 +117,18 @@ bool resource_has_available_units(Resource* resource, int requested_units);
 /* Get utilization percentage (0.0 to 1.0) */
 double resource_get_utilization(Resource* resource);
 
+/* Measure busy units and waiting against sim's clock from its current
+ * time on. A resource used inside a run binds to that simulator by itself;
+ * bind explicitly to query one that only changes outside runs. Destroying
+ * the simulator drops the binding, so a resource reused across
+ * replications follows the next simulator. */
+void resource_set_simulator(Resource* resource, Simulator* sim);
+
+/* Time-average busy units and utilization since creation, binding or
+ * reset, up to the simulator's current time */
+double resource_get_average_busy_units(Resource* resource);
+double resource_get_average_utilization(Resource* resource);
+
 /* Reset resource to initial state */
 void resource_reset(Resource* resource);
 
@@ -1,15 +1,55 @@
 #include "random.h"
 #include <math.h>
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 /* PCG32 random number generator constants */
 #define PCG32_DEFAULT_STATE  0x853c49e6748fea9bULL
 #define PCG32_DEFAULT_STREAM 0xda3e39cb94b95bdbULL
 #define PCG32_MULT           0x5851f42d4c957f2dULL
 
-/* Global random number generator */
-static Random global_rng;
+/* Philox4x32-10 multipliers and key increments (Random123) */
+#define PHILOX_ROUNDS 10
+#define PHILOX_M0     0xd2511f53u
+#define PHILOX_M1     0xcd9e8d57u
+#define PHILOX_W0     0x9e3779b9u
+#define PHILOX_W1     0xbb67ae85u
+#define PHILOX_GROUP  8     /* Blocks per draw group, the widest vector's lanes */
+
+/* Global random number generator, one per thread; a replication may
+ * install its own stream in place of the thread's default */
+static _Thread_local Random default_rng;
+static _Thread_local bool default_rng_seeded = false;
+static _Thread_local Random* global_rng = NULL;
+static _Thread_local RandomStream global_streams[RANDOM_STREAM_NORMAL + 1];
+static _Thread_local bool global_streams_ready = false;
+
+/* Thread default streams: with a process seed set, each thread's default
+ * generator is stream thread_stream of it. Ids not chosen with
+ * random_set_thread_stream are handed out in order of first use. */
+static atomic_uint_fast64_t process_seed;
+static atomic_bool process_seed_set;
+static atomic_uint_fast64_t next_thread_stream;
+static _Thread_local uint64_t thread_stream;
+static _Thread_local bool thread_stream_assigned = false;
+
+/* How random_normal and random_exponential sample, for every thread */
+static atomic_int variate_method = RANDOM_METHOD_ZIGGURAT;
+
+static void init_global_rng(void);
+
+static inline Random* global_generator(void) {
+    if (global_rng == NULL) {
+        init_global_rng();
+    }
+    return global_rng;
+}
 
 /* Internal PCG32 implementation */
 static uint32_t pcg32_random(Random* rng) {
@@ -20,6 +60,242 @@ static uint32_t pcg32_random(Random* rng) {
     return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
 }
 
+/* 64 bits from two draws */
+static uint64_t pcg32_random64(Random* rng) {
+    uint64_t high = pcg32_random(rng);
+    return (high << 32) | pcg32_random(rng);
+}
+
+/* Uniform in [0, 1) with 53 bits */
+static double pcg32_unit53(Random* rng) {
+    return (double)(pcg32_random64(rng) >> 11) * 0x1p-53;
+}
+
+/* Multiplier and increment that move a PCG state delta steps in one affine
+ * step, by repeated squaring (Brown, "Random Number Generation with
+ * Arbitrary Strides") */
+static void pcg32_jump(uint64_t delta, uint64_t inc, uint64_t* mult, uint64_t* plus) {
+    uint64_t step_mult = PCG32_MULT;
+    uint64_t step_plus = inc;
+    uint64_t acc_mult = 1;
+    uint64_t acc_plus = 0;
+
+    while (delta > 0) {
+        if (delta & 1) {
+            acc_mult *= step_mult;
+            acc_plus = acc_plus * step_mult + step_plus;
+        }
+        step_plus = (step_mult + 1) * step_plus;
+        step_mult *= step_mult;
+        delta >>= 1;
+    }
+    *mult = acc_mult;
+    *plus = acc_plus;
+}
+
+/* rng's state after delta more draws */
+static uint64_t pcg32_advance_state(const Random* rng, uint64_t delta) {
+    uint64_t mult, plus;
+    pcg32_jump(delta, rng->inc, &mult, &plus);
+    return rng->state * mult + plus;
+}
+
+/* Ziggurat samplers. Each variate takes 64 bits: the layer, the sign and
+ * the magnitude come from separate bits (Doornik's fix to the original
+ * 32-bit method), and about 99% of draws end at the first comparison. */
+#include "random_ziggurat.inc"
+
+static double ziggurat_normal(Random* rng) {
+    for (;;) {
+        uint64_t bits = pcg32_random64(rng);
+        int layer = (int)(bits & 0xff);
+        bool negative = (bits >> 8) & 1;
+        uint64_t magnitude = (bits >> 9) & 0x000fffffffffffffULL;
+        double x = (double)magnitude * ziggurat_normal_w[layer];
+
+        if (magnitude < ziggurat_normal_k[layer]) {
+            return negative ? -x : x;
+        }
+        if (layer == 0) {
+            /* Tail beyond R (Marsaglia's exponential rejection) */
+            double tail, y;
+            do {
+                tail = -log1p(-pcg32_unit53(rng)) / ZIGGURAT_NORMAL_R;
+                y = -log1p(-pcg32_unit53(rng));
+            } while (y + y < tail * tail);
+            x = ZIGGURAT_NORMAL_R + tail;
+            return negative ? -x : x;
+        }
+        double f_low = ziggurat_normal_f[layer];
+        if ((ziggurat_normal_f[layer - 1] - f_low) * pcg32_unit53(rng) + f_low < exp(-0.5 * x * x)) {
+            return negative ? -x : x;
+        }
+    }
+}
+
+static double ziggurat_exponential(Random* rng) {
+    for (;;) {
+        uint64_t bits = pcg32_random64(rng) >> 3;
+        int layer = (int)(bits & 0xff);
+        uint64_t magnitude = bits >> 8;
+        double x = (double)magnitude * ziggurat_exp_w[layer];
+
+        if (magnitude < ziggurat_exp_k[layer]) {
+            return x;
+        }
+        if (layer == 0) {
+            /* The tail beyond R is R plus another exponential */
+            return ZIGGURAT_EXP_R - log1p(-pcg32_unit53(rng));
+        }
+        double f_low = ziggurat_exp_f[layer];
+        if ((ziggurat_exp_f[layer - 1] - f_low) * pcg32_unit53(rng) + f_low < exp(-x)) {
+            return x;
+        }
+    }
+}
+
+/* One Philox4x32-10 block: counter (block, stream), key seed */
+static void philox_block(uint64_t seed, uint64_t stream, uint64_t block, uint32_t out[4]) {
+    uint32_t x0 = (uint32_t)block;
+    uint32_t x1 = (uint32_t)(block >> 32);
+    uint32_t x2 = (uint32_t)stream;
+    uint32_t x3 = (uint32_t)(stream >> 32);
+    uint32_t k0 = (uint32_t)seed;
+    uint32_t k1 = (uint32_t)(seed >> 32);
+
+    for (int round = 0; round < PHILOX_ROUNDS; round++) {
+        uint64_t p0 = (uint64_t)x0 * PHILOX_M0;
+        uint64_t p1 = (uint64_t)x2 * PHILOX_M1;
+        x0 = (uint32_t)(p1 >> 32) ^ x1 ^ k0;
+        x1 = (uint32_t)p1;
+        x2 = (uint32_t)(p0 >> 32) ^ x3 ^ k1;
+        x3 = (uint32_t)p0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = x0;
+    out[1] = x1;
+    out[2] = x2;
+    out[3] = x3;
+}
+
+/* Bulk kernels: a portable two-lane build, plus AVX2 and AVX-512 builds
+ * chosen at run time on x86. Fusing multiply-adds (AVX-512 implies FMA)
+ * would round differently per build, so contraction is off for them. */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#endif
+#define FILL_LANES 2
+#define FILL_SUFFIX base
+#define FILL_TARGET
+#if defined(__SSE2__)
+#define FILL_SQRT(v) ((FillF64_base)_mm_sqrt_pd((__m128d)(v)))
+#define FILL_MUL32(a, b) ((FillU64_base)_mm_mul_epu32((__m128i)(a), (__m128i)(b)))
+#else
+#define FILL_SQRT(v) __extension__({ FillF64_base root_ = (v); \
+    root_[0] = sqrt(root_[0]); root_[1] = sqrt(root_[1]); root_; })
+#define FILL_MUL32(a, b) ((a) * (b))
+#endif
+#include "random_fill.inc"
+#undef FILL_LANES
+#undef FILL_SUFFIX
+#undef FILL_TARGET
+#undef FILL_SQRT
+#undef FILL_MUL32
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define RANDOM_FILL_DISPATCH 1
+
+#define FILL_LANES 4
+#define FILL_SUFFIX avx2
+#define FILL_TARGET __attribute__((target("avx2")))
+#define FILL_SQRT(v) ((FillF64_avx2)_mm256_sqrt_pd((__m256d)(v)))
+#define FILL_MUL32(a, b) ((FillU64_avx2)_mm256_mul_epu32((__m256i)(a), (__m256i)(b)))
+#include "random_fill.inc"
+#undef FILL_LANES
+#undef FILL_SUFFIX
+#undef FILL_TARGET
+#undef FILL_SQRT
+#undef FILL_MUL32
+
+#define FILL_LANES 8
+#define FILL_SUFFIX avx512
+#define FILL_TARGET __attribute__((target("avx512f")))
+#define FILL_SQRT(v) ((FillF64_avx512)_mm512_sqrt_pd((__m512d)(v)))
+#define FILL_MUL32(a, b) ((FillU64_avx512)_mm512_mul_epu32((__m512i)(a), (__m512i)(b)))
+#include "random_fill.inc"
+#undef FILL_LANES
+#undef FILL_SUFFIX
+#undef FILL_TARGET
+#undef FILL_SQRT
+#undef FILL_MUL32
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC pop_options
+#endif
+
+typedef enum { FILL_BASE, FILL_AVX2, FILL_AVX512 } FillLevel;
+
+static FillLevel detect_fill_level(void) {
+#ifdef RANDOM_FILL_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return FILL_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return FILL_AVX2;
+    }
+#endif
+    return FILL_BASE;
+}
+
+/* Detected on first use; threads racing to it all store the same level */
+static atomic_int cached_fill_level = -1;
+
+static FillLevel fill_level(void) {
+    int level = atomic_load_explicit(&cached_fill_level, memory_order_relaxed);
+    if (level < 0) {
+        level = (int)detect_fill_level();
+        atomic_store_explicit(&cached_fill_level, level, memory_order_relaxed);
+    }
+    return (FillLevel)level;
+}
+
+/* SplitMix64's finalizer reduced mod 2^63: xor-shifts and odd multiplies
+ * stay bijective there, so nearby stream ids spread apart and the result
+ * still fits the increment's 63 free bits */
+#define STREAM_MASK 0x7fffffffffffffffULL
+
+static uint64_t mix63(uint64_t x) {
+    x &= STREAM_MASK;
+    x = ((x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL) & STREAM_MASK;
+    x = ((x ^ (x >> 27)) * 0x94d049bb133111ebULL) & STREAM_MASK;
+    return x ^ (x >> 31);
+}
+
+void random_init_stream(Random* rng, uint64_t seed, uint64_t stream) {
+    if (rng == NULL) {
+        return;
+    }
+
+    /* pcg32_srandom: the stream picks the increment, the seed the position */
+    rng->state = 0;
+    rng->inc = (mix63(stream) << 1) | 1;
+    pcg32_random(rng);
+    rng->state += seed;
+    pcg32_random(rng);
+}
+
+void random_advance(Random* rng, uint64_t delta) {
+    if (rng != NULL) {
+        rng->state = pcg32_advance_state(rng, delta);
+    }
+}
+
 void random_init(Random* rng, uint64_t seed) {
     if (rng == NULL) {
         return;
@@ -50,6 +326,9 @@ double random_normal(Random* rng, double mean, double stddev) {
     if (rng == NULL) {
         return mean;
     }
+    if (random_get_method() == RANDOM_METHOD_ZIGGURAT) {
+        return mean + ziggurat_normal(rng) * stddev;
+    }
 
     /* Box-Muller transform */
     double u1 = random_uniform(rng);
@@ -63,6 +342,9 @@ double random_exponential(Random* rng, double rate) {
     if (rng == NULL || rate <= 0.0) {
         return 0.0;
     }
+    if (random_get_method() == RANDOM_METHOD_ZIGGURAT) {
+        return ziggurat_exponential(rng) / rate;
+    }
 
     double u = random_uniform(rng);
     return -log(u) / rate;
@@ -171,37 +453,353 @@ double random_lognormal(Random* rng, double mean, double stddev) {
     return exp(mean + stddev * normal);
 }
 
+void random_uniform_fill(Random* rng, double* out, size_t n) {
+    if (rng == NULL || out == NULL || n == 0) {
+        return;
+    }
+
+    switch (fill_level()) {
+#ifdef RANDOM_FILL_DISPATCH
+        case FILL_AVX512: uniform_fill_avx512(rng, out, n); break;
+        case FILL_AVX2:   uniform_fill_avx2(rng, out, n); break;
+#endif
+        default:          uniform_fill_base(rng, out, n); break;
+    }
+}
+
+void random_normal_fill(Random* rng, double* out, size_t n, double mean, double stddev) {
+    if (out == NULL || n == 0) {
+        return;
+    }
+    if (rng == NULL) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = mean;
+        }
+        return;
+    }
+
+    switch (fill_level()) {
+#ifdef RANDOM_FILL_DISPATCH
+        case FILL_AVX512: normal_fill_avx512(rng, out, n, mean, stddev); break;
+        case FILL_AVX2:   normal_fill_avx2(rng, out, n, mean, stddev); break;
+#endif
+        default:          normal_fill_base(rng, out, n, mean, stddev); break;
+    }
+}
+
+void random_exponential_fill(Random* rng, double* out, size_t n, double rate) {
+    if (out == NULL || n == 0) {
+        return;
+    }
+    if (rng == NULL || rate <= 0.0) {
+        memset(out, 0, n * sizeof(double));
+        return;
+    }
+
+    switch (fill_level()) {
+#ifdef RANDOM_FILL_DISPATCH
+        case FILL_AVX512: exponential_fill_avx512(rng, out, n, rate); break;
+        case FILL_AVX2:   exponential_fill_avx2(rng, out, n, rate); break;
+#endif
+        default:          exponential_fill_base(rng, out, n, rate); break;
+    }
+}
+
+void random_set_method(RandomMethod method) {
+    atomic_store_explicit(&variate_method, (int)method, memory_order_relaxed);
+}
+
+RandomMethod random_get_method(void) {
+    return (RandomMethod)atomic_load_explicit(&variate_method, memory_order_relaxed);
+}
+
+/* Counter-based generator */
+void random_philox_init(Philox* rng, uint64_t seed, uint64_t stream) {
+    if (rng == NULL) {
+        return;
+    }
+
+    rng->seed = seed;
+    rng->stream = stream;
+    rng->index = 0;
+}
+
+/* Draws come in groups of 4 * PHILOX_GROUP: draw i is word (i / 8) % 4 of
+ * block (i / 32) * 8 + i % 8 */
+static uint64_t philox_block_of(uint64_t index) {
+    return index / (4 * PHILOX_GROUP) * PHILOX_GROUP + index % PHILOX_GROUP;
+}
+
+static int philox_word_of(uint64_t index) {
+    return (int)(index / PHILOX_GROUP % 4);
+}
+
+uint32_t random_philox_bits(uint64_t seed, uint64_t stream, uint64_t index) {
+    uint32_t words[4];
+    philox_block(seed, stream, philox_block_of(index), words);
+    return words[philox_word_of(index)];
+}
+
+static void philox_fill(Philox* rng, double* out, size_t n, RandomStreamKind kind,
+                        double a, double b) {
+    switch (fill_level()) {
+#ifdef RANDOM_FILL_DISPATCH
+        case FILL_AVX512: philox_fill_avx512(rng, out, n, kind, a, b); break;
+        case FILL_AVX2:   philox_fill_avx2(rng, out, n, kind, a, b); break;
+#endif
+        default:          philox_fill_base(rng, out, n, kind, a, b); break;
+    }
+}
+
+/* One variate from its block, through the portable kernel's transforms
+ * so it matches the fills bit for bit */
+static double philox_variate(Philox* rng, RandomStreamKind kind, double a, double b) {
+    uint32_t words[4];
+    FillU64_base word[4];
+    FillF64_base v[4];
+
+    philox_block(rng->seed, rng->stream, philox_block_of(rng->index), words);
+    for (int j = 0; j < 4; j++) {
+        word[j] = (FillU64_base){ words[j], 0 };
+    }
+    philox_transform_base(word, v, kind, a, b);
+    return v[philox_word_of(rng->index++)][0];
+}
+
+double random_philox_uniform(Philox* rng) {
+    if (rng == NULL) {
+        return 0.0;
+    }
+    return (double)random_philox_bits(rng->seed, rng->stream, rng->index++) * 0x1p-32;
+}
+
+double random_philox_normal(Philox* rng, double mean, double stddev) {
+    if (rng == NULL) {
+        return mean;
+    }
+    return philox_variate(rng, RANDOM_STREAM_NORMAL, mean, stddev);
+}
+
+double random_philox_exponential(Philox* rng, double rate) {
+    if (rng == NULL || rate <= 0.0) {
+        return 0.0;
+    }
+    return philox_variate(rng, RANDOM_STREAM_EXPONENTIAL, rate, 0.0);
+}
+
+void random_philox_uniform_fill(Philox* rng, double* out, size_t n) {
+    if (rng == NULL || out == NULL || n == 0) {
+        return;
+    }
+    philox_fill(rng, out, n, RANDOM_STREAM_UNIFORM, 0.0, 0.0);
+}
+
+void random_philox_normal_fill(Philox* rng, double* out, size_t n, double mean, double stddev) {
+    if (out == NULL || n == 0) {
+        return;
+    }
+    if (rng == NULL) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = mean;
+        }
+        return;
+    }
+    philox_fill(rng, out, n, RANDOM_STREAM_NORMAL, mean, stddev);
+}
+
+void random_philox_exponential_fill(Philox* rng, double* out, size_t n, double rate) {
+    if (out == NULL || n == 0) {
+        return;
+    }
+    if (rng == NULL || rate <= 0.0) {
+        memset(out, 0, n * sizeof(double));
+        return;
+    }
+    philox_fill(rng, out, n, RANDOM_STREAM_EXPONENTIAL, rate, 0.0);
+}
+
+/* Buffered streams */
+void random_stream_init(RandomStream* stream, const Random* source, RandomStreamKind kind) {
+    if (stream == NULL || source == NULL) {
+        return;
+    }
+
+    stream->next = stream->buffer;
+    stream->end = stream->buffer;
+    stream->kind = kind;
+    stream->reseed = false;
+    stream->rng = *source;
+    stream->refill_rng = *source;
+}
+
+double random_stream_refill(RandomStream* stream) {
+    if (stream->reseed) {
+        Random* global = global_generator();
+        uint64_t high = pcg32_random(global);
+        random_init(&stream->rng, (high << 32) | pcg32_random(global));
+        stream->reseed = false;
+    }
+
+    stream->refill_rng = stream->rng;
+    switch (stream->kind) {
+        case RANDOM_STREAM_EXPONENTIAL:
+            random_exponential_fill(&stream->rng, stream->buffer, RANDOM_STREAM_BUFFER, 1.0);
+            break;
+        case RANDOM_STREAM_NORMAL:
+            random_normal_fill(&stream->rng, stream->buffer, RANDOM_STREAM_BUFFER, 0.0, 1.0);
+            break;
+        case RANDOM_STREAM_UNIFORM:
+        default:
+            random_uniform_fill(&stream->rng, stream->buffer, RANDOM_STREAM_BUFFER);
+            break;
+    }
+
+    stream->end = stream->buffer + RANDOM_STREAM_BUFFER;
+    stream->next = stream->buffer + 1;
+    return stream->buffer[0];
+}
+
+void random_stream_discard(RandomStream* stream) {
+    if (stream == NULL) {
+        return;
+    }
+
+    stream->next = stream->end;
+    if (stream >= global_streams && stream <= &global_streams[RANDOM_STREAM_NORMAL]) {
+        stream->reseed = true;
+    }
+}
+
+void random_stream_seek(RandomStream* stream, const Random* refill_rng, uint32_t used) {
+    if (stream == NULL || refill_rng == NULL) {
+        return;
+    }
+
+    stream->rng = *refill_rng;
+    stream->reseed = false;
+    random_stream_refill(stream);
+    stream->next = stream->buffer + (used < RANDOM_STREAM_BUFFER ? used : RANDOM_STREAM_BUFFER);
+}
+
+RandomStream* random_stream_global(RandomStreamKind kind) {
+    if (!global_streams_ready) {
+        for (int i = 0; i <= RANDOM_STREAM_NORMAL; i++) {
+            random_stream_init(&global_streams[i], global_generator(), (RandomStreamKind)i);
+            global_streams[i].reseed = true;
+        }
+        global_streams_ready = true;
+    }
+    if ((unsigned)kind > RANDOM_STREAM_NORMAL) {
+        kind = RANDOM_STREAM_UNIFORM;
+    }
+    return &global_streams[kind];
+}
+
+/* Buffered draws belong to the generator they came from */
+static void discard_global_streams(void) {
+    if (global_streams_ready) {
+        for (int i = 0; i <= RANDOM_STREAM_NORMAL; i++) {
+            random_stream_discard(&global_streams[i]);
+        }
+    }
+}
+
 /* Global random number generator functions */
 void random_seed(uint64_t seed) {
-    random_init(&global_rng, seed);
+    random_init(global_generator(), seed);
+    discard_global_streams();
+}
+
+/* Reinitialize this thread's default generator from the process seed */
+static void reset_default_stream(void) {
+    if (!thread_stream_assigned) {
+        thread_stream = atomic_fetch_add(&next_thread_stream, 1);
+        thread_stream_assigned = true;
+    }
+    random_init_stream(&default_rng, atomic_load(&process_seed), thread_stream);
+    default_rng_seeded = true;
+    if (global_rng == &default_rng) {
+        discard_global_streams();
+    }
+}
+
+void random_seed_threads(uint64_t seed) {
+    atomic_store(&process_seed, seed);
+    atomic_store(&process_seed_set, true);
+    reset_default_stream();
+}
+
+void random_set_thread_stream(uint64_t stream) {
+    thread_stream = stream;
+    thread_stream_assigned = true;
+    if (atomic_load(&process_seed_set)) {
+        reset_default_stream();
+    }
+}
+
+uint64_t random_get_thread_stream(void) {
+    if (!thread_stream_assigned) {
+        thread_stream = atomic_fetch_add(&next_thread_stream, 1);
+        thread_stream_assigned = true;
+    }
+    return thread_stream;
+}
+
+Random* random_set_global(Random* rng) {
+    Random* previous = global_generator();
+    global_rng = (rng != NULL) ? rng : &default_rng;
+    discard_global_streams();
+    return previous;
+}
+
+Random* random_get_global(void) {
+    return global_generator();
 }
 
 double random_uniform_global(void) {
-    return random_uniform(&global_rng);
+    return random_uniform(global_generator());
 }
 
 int random_uniform_int_global(int min, int max) {
-    return random_uniform_int(&global_rng, min, max);
+    return random_uniform_int(global_generator(), min, max);
 }
 
 double random_normal_global(double mean, double stddev) {
-    return random_normal(&global_rng, mean, stddev);
+    return random_normal(global_generator(), mean, stddev);
 }
 
 double random_exponential_global(double rate) {
-    return random_exponential(&global_rng, rate);
+    return random_exponential(global_generator(), rate);
 }
 
 int random_poisson_global(double lambda) {
-    return random_poisson(&global_rng, lambda);
+    return random_poisson(global_generator(), lambda);
+}
+
+void random_uniform_fill_global(double* out, size_t n) {
+    random_uniform_fill(global_generator(), out, n);
 }
 
-/* Initialize global generator with current time on first use */
+void random_normal_fill_global(double* out, size_t n, double mean, double stddev) {
+    random_normal_fill(global_generator(), out, n, mean, stddev);
+}
+
+void random_exponential_fill_global(double* out, size_t n, double rate) {
+    random_exponential_fill(global_generator(), out, n, rate);
+}
+
+/* Initialize this thread's generator on first use: from the process seed
+ * if one is set, else from the current time, with the thread's address
+ * keeping threads started together apart */
 static void init_global_rng(void) {
-    static int initialized = 0;
-    if (!initialized) {
-        random_seed((uint64_t)time(NULL));
-        initialized = 1;
+    global_rng = &default_rng;
+    if (!default_rng_seeded) {
+        if (atomic_load(&process_seed_set)) {
+            reset_default_stream();
+        } else {
+            random_init(&default_rng, (uint64_t)time(NULL) ^ (uint64_t)(uintptr_t)&default_rng);
+            default_rng_seeded = true;
+        }
     }
 }
 
@@ -4,6 +4,8 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* Random number generator for SIMSCRIPT */
@@ -15,12 +17,36 @@ typedef struct Random {
 /* Initialize random number generator with seed */
 void random_init(Random* rng, uint64_t seed);
 
+/* Stream number stream of seed: PCG's stream selector (the increment) is
+ * derived from stream, so distinct streams of one seed never share a
+ * sequence and need no coordination between threads. The increment has 63
+ * free bits, so ids below 2^63 are distinct; stream and stream + 2^63 are
+ * the same stream. */
+void random_init_stream(Random* rng, uint64_t seed, uint64_t stream);
+
+/* Skip delta draws in O(log delta); delta wraps, so (uint64_t)-k goes back k */
+void random_advance(Random* rng, uint64_t delta);
+
 /* Generate uniform random double in [0, 1) */
 double random_uniform(Random* rng);
 
 /* Generate uniform random integer in [min, max] */
 int random_uniform_int(Random* rng, int min, int max);
 
+/* How random_normal and random_exponential sample. The ziggurat method
+ * (default) needs a table lookup and a multiply for nearly every variate;
+ * the transforms are Box-Muller and -log(u), for results matching older
+ * runs. random_lognormal, random_gamma and random_poisson's normal
+ * approximation follow the choice; buffered streams and fills do not. */
+typedef enum {
+    RANDOM_METHOD_ZIGGURAT,
+    RANDOM_METHOD_TRANSFORM
+} RandomMethod;
+
+/* Set the method for all threads */
+void random_set_method(RandomMethod method);
+RandomMethod random_get_method(void);
+
 /* Generate normal (Gaussian) random number with mean and stddev */
 double random_normal(Random* rng, double mean, double stddev);
 
@@ -45,9 +71,124 @@ double random_weibull(Random* rng, double shape, double scale);
 /* Generate random number from log-normal distribution */
 double random_lognormal(Random* rng, double mean, double stddev);
 
-/* Set seed for global random number generator */
+/* Bulk generation, several PCG lanes at a time (AVX2 or AVX-512 when the
+ * CPU has them). random_uniform_fill writes exactly what n random_uniform
+ * calls would return. The normal and exponential fills apply the same
+ * transforms to the same draws with their own log/sin/cos, so values can
+ * differ from the scalar functions in the last bits (and are never
+ * infinite); random_normal_fill keeps both Box-Muller variates and uses an
+ * even number of draws. Results do not depend on the instruction set. */
+void random_uniform_fill(Random* rng, double* out, size_t n);
+void random_normal_fill(Random* rng, double* out, size_t n, double mean, double stddev);
+void random_exponential_fill(Random* rng, double* out, size_t n, double rate);
+
+/* Counter-based generator (Philox4x32-10, Salmon et al., "Parallel Random
+ * Numbers: As Easy as 1, 2, 3"). Draw index of stream under seed is a pure
+ * function of the three numbers: seed is the cipher key and (stream,
+ * block) the counter, with four draws per block. Draws can be computed in
+ * any order and split among threads in any way with the same results, and
+ * the state is just the struct (set index to seek). */
+typedef struct Philox {
+    uint64_t seed;
+    uint64_t stream;
+    uint64_t index;            /* Next draw */
+} Philox;
+
+void random_philox_init(Philox* rng, uint64_t seed, uint64_t stream);
+
+/* The 32-bit draw index of stream */
+uint32_t random_philox_bits(uint64_t seed, uint64_t stream, uint64_t index);
+
+/* Variates from the next draws, one draw per variate; uniform variates
+ * are draw * 2^-32, in [0, 1). A block's four words are draws i, i + 8,
+ * i + 16 and i + 24 (so vectors store whole words), and normal variates
+ * pair words 0, 1 and 2, 3 for Box-Muller. The fills compute many blocks
+ * at once (AVX2 or AVX-512 when the CPU has them) and return exactly what
+ * the one-at-a-time functions would, on any instruction set. */
+double random_philox_uniform(Philox* rng);
+double random_philox_normal(Philox* rng, double mean, double stddev);
+double random_philox_exponential(Philox* rng, double rate);
+void random_philox_uniform_fill(Philox* rng, double* out, size_t n);
+void random_philox_normal_fill(Philox* rng, double* out, size_t n, double mean, double stddev);
+void random_philox_exponential_fill(Philox* rng, double* out, size_t n, double rate);
+
+/* Buffered variates: a stream keeps a block of unit variates (uniform,
+ * rate-1 exponential or standard normal) refilled by the bulk kernels, so
+ * a draw is usually a pointer bump. next and end come first because
+ * compiled code reads them directly. */
+#define RANDOM_STREAM_BUFFER 256
+
+typedef enum {
+    RANDOM_STREAM_UNIFORM,
+    RANDOM_STREAM_EXPONENTIAL,
+    RANDOM_STREAM_NORMAL
+} RandomStreamKind;
+
+typedef struct RandomStream {
+    double* next;              /* Next buffered variate */
+    double* end;               /* Past the last one; next == end when empty */
+    RandomStreamKind kind;
+    bool reseed;               /* Seed from the global generator at the next refill */
+    Random rng;                /* Generator after the last refill */
+    Random refill_rng;         /* Generator before the last refill */
+    double buffer[RANDOM_STREAM_BUFFER];
+} RandomStream;
+
+/* Draw from a copy of source */
+void random_stream_init(RandomStream* stream, const Random* source, RandomStreamKind kind);
+
+/* Refill the buffer and return its first variate */
+double random_stream_refill(RandomStream* stream);
+
+/* Drop buffered variates; a global stream reseeds at its next draw */
+void random_stream_discard(RandomStream* stream);
+
+/* Rebuild the buffer a refill from refill_rng produced, with used variates
+ * already drawn (checkpoint restore) */
+void random_stream_seek(RandomStream* stream, const Random* refill_rng, uint32_t used);
+
+/* This thread's stream of the given kind. It seeds itself from the global
+ * generator, again after every random_seed or random_set_global. */
+RandomStream* random_stream_global(RandomStreamKind kind);
+
+static inline double random_stream_next(RandomStream* stream) {
+    return (stream->next != stream->end) ? *stream->next++ : random_stream_refill(stream);
+}
+
+static inline double random_stream_uniform(RandomStream* stream) {
+    return random_stream_next(stream);
+}
+
+static inline double random_stream_exponential(RandomStream* stream, double rate) {
+    return (rate > 0.0) ? random_stream_next(stream) / rate : 0.0;
+}
+
+static inline double random_stream_normal(RandomStream* stream, double mean, double stddev) {
+    return mean + random_stream_next(stream) * stddev;
+}
+
+/* Set seed for global random number generator (per thread) */
 void random_seed(uint64_t seed);
 
+/* Seed every thread's default generator: each becomes stream
+ * random_get_thread_stream() of seed, so results depend on which work a
+ * stream id does, not on how many threads run it. Applies to the calling
+ * thread now and to other threads at their next random_set_thread_stream
+ * or first draw. */
+void random_seed_threads(uint64_t seed);
+
+/* Choose this thread's stream id (e.g. a worker or task index); threads
+ * that never choose get ids in order of first use, the first thread 0 */
+void random_set_thread_stream(uint64_t stream);
+uint64_t random_get_thread_stream(void);
+
+/* Make rng this thread's global generator (NULL restores the default);
+ * returns the previous one */
+Random* random_set_global(Random* rng);
+
+/* This thread's global generator */
+Random* random_get_global(void);
+
 /* Generate uniform random double in [0, 1) using global generator */
 double random_uniform_global(void);
 
@@ -63,6 +204,11 @@ double random_exponential_global(double rate);
 /* Generate Poisson random number using global generator */
 int random_poisson_global(double lambda);
 
+/* Bulk generation using global generator */
+void random_uniform_fill_global(double* out, size_t n);
+void random_normal_fill_global(double* out, size_t n, double mean, double stddev);
+void random_exponential_fill_global(double* out, size_t n, double rate);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -272,6 +272,95 @@ double stats_poisson_pmf(int k, double lambda) {
     return exp(log_pmf);
 }
 
+/* Acklam's rational approximation, refined by one Halley step */
+double stats_normal_quantile(double p) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02,
+                               -2.759285104469687e+02, 1.383577518672690e+02,
+                               -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02,
+                               -1.556989798598866e+02, 6.680131188771972e+01,
+                               -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01,
+                               -2.400758277161838e+00, -2.549732539343734e+00,
+                               4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01,
+                               2.445134137142996e+00, 3.754408661907416e+00};
+
+    if (p <= 0.0) {
+        return -INFINITY;
+    }
+    if (p >= 1.0) {
+        return INFINITY;
+    }
+
+    double x;
+    if (p < 0.02425) {
+        double q = sqrt(-2.0 * log(p));
+        x = (((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+            ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1.0);
+    } else if (p > 1.0 - 0.02425) {
+        double q = sqrt(-2.0 * log(1.0 - p));
+        x = -(((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+             ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1.0);
+    } else {
+        double q = p - 0.5;
+        double r = q * q;
+        x = (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5])*q /
+            (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1.0);
+    }
+
+    double e = stats_normal_cdf(x, 0.0, 1.0) - p;
+    double u = e * sqrt(2.0 * M_PI) * exp(0.5 * x * x);
+    return x - u / (1.0 + 0.5 * x * u);
+}
+
+/* Hill's algorithm 396; exact for 1 and 2 degrees of freedom */
+double stats_t_quantile(double p, int df) {
+    if (df <= 0 || p <= 0.0 || p >= 1.0) {
+        return stats_normal_quantile(p);
+    }
+    if (p == 0.5) {
+        return 0.0;
+    }
+
+    /* Two-tailed probability of exceeding |t| */
+    double tail = 2.0 * (p < 0.5 ? p : 1.0 - p);
+    double n = (double)df;
+    double t;
+
+    if (df == 1) {
+        double angle = tail * M_PI / 2.0;
+        t = cos(angle) / sin(angle);
+    } else if (df == 2) {
+        t = sqrt(2.0 / (tail * (2.0 - tail)) - 2.0);
+    } else {
+        double a = 1.0 / (n - 0.5);
+        double b = 48.0 / (a * a);
+        double c = ((20700.0 * a / b - 98.0) * a - 16.0) * a + 96.36;
+        double d = ((94.5 / (b + c) - 3.0) / b + 1.0) * sqrt(a * M_PI / 2.0) * n;
+        double x = d * tail;
+        double y = pow(x, 2.0 / n);
+
+        if (y > 0.05 + a) {
+            x = stats_normal_quantile(0.5 * tail);
+            y = x * x;
+            if (df < 5) {
+                c += 0.3 * (n - 4.5) * (x + 0.6);
+            }
+            c = (((0.05 * d * x - 5.0) * x - 7.0) * x - 2.0) * x + b + c;
+            y = (((((0.4 * y + 6.3) * y + 36.0) * y + 94.5) / c - y - 3.0) / b + 1.0) * x;
+            y = a * y * y;
+            y = (y > 0.002) ? exp(y) - 1.0 : 0.5 * y * y + y;
+        } else {
+            y = ((1.0 / (((n + 6.0) / (n * y) - 0.089 * d - 0.822) * (n + 2.0) * 3.0) +
+                  0.5 / (n + 4.0)) * y - 1.0) * (n + 1.0) / (n + 2.0) + 1.0 / y;
+        }
+        t = sqrt(n * y);
+    }
+
+    return p < 0.5 ? -t : t;
+}
+
 TestResult stats_t_test(const double* sample1, int n1,
                        const double* sample2, int n2,
                        double alpha) {
@@ -351,9 +440,10 @@ ConfidenceInterval stats_mean_ci(const double* data, int n, double confidence) {
     double stddev = stats_stddev(data, n);
     double se = stddev / sqrt(n);
 
-    double z = -stats_normal_cdf(0.0, (1.0 - confidence)/2.0, 1.0);
-    ci.lower = mean - z * se;
-    ci.upper = mean + z * se;
+    /* Student t: the variance is estimated from the same sample */
+    double t = stats_t_quantile(0.5 + confidence / 2.0, n - 1);
+    ci.lower = mean - t * se;
+    ci.upper = mean + t * se;
 
     return ci;
 }
@@ -369,7 +459,7 @@ ConfidenceInterval stats_proportion_ci(int successes, int trials, double confide
     double p = (double)successes / trials;
     double se = sqrt(p * (1.0 - p) / trials);
 
-    double z = -stats_normal_cdf(0.0, (1.0 - confidence)/2.0, 1.0);
+    double z = stats_normal_quantile(0.5 + confidence / 2.0);
     ci.lower = p - z * se;
     ci.upper = p + z * se;
 
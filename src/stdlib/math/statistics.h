@@ -36,6 +36,10 @@ double stats_exponential_pdf(double x, double rate);
 double stats_exponential_cdf(double x, double rate);
 double stats_poisson_pmf(int k, double lambda);
 
+/* Quantiles: x with P(X <= x) = p, for 0 < p < 1 */
+double stats_normal_quantile(double p);
+double stats_t_quantile(double p, int df);
+
 /* Hypothesis testing */
 typedef struct {
     double statistic;
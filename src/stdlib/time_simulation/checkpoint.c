@@ -0,0 +1,452 @@
+#include "checkpoint.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECKPOINT_MAGIC UINT64_C(0x3130544b50434b53)  /* "SKCPKT01" */
+#define CHECKPOINT_END UINT64_C(0x444e45544b50434b)    /* "KCPKTEND" */
+#define CHECKPOINT_VERSION 2
+#define CHECKPOINT_BYTE_ORDER UINT32_C(0x01020304)
+
+#ifdef SIM_TIME_INTEGER
+#define CHECKPOINT_TIME_FORMAT 1
+#define CHECKPOINT_TIME_RESOLUTION SIM_TIME_RESOLUTION
+#else
+#define CHECKPOINT_TIME_FORMAT 0
+#define CHECKPOINT_TIME_RESOLUTION 0
+#endif
+
+/* How an event's data is stored */
+enum {
+    PAYLOAD_NONE,
+    PAYLOAD_BYTES,             /* Copied payload, stored verbatim */
+    PAYLOAD_SERIALIZED         /* Written by the handler's serializer */
+};
+
+typedef struct PayloadSerializer {
+    EventHandler handler;
+    CheckpointSave save;
+    CheckpointLoad load;
+} PayloadSerializer;
+
+static PayloadSerializer* serializers = NULL;
+static int serializer_count = 0;
+static int serializer_capacity = 0;
+
+typedef struct EventList {
+    Event** events;
+    int count;
+    int capacity;
+    bool failed;
+} EventList;
+
+static const PayloadSerializer* find_serializer(EventHandler handler) {
+    for (int i = 0; i < serializer_count; i++) {
+        if (serializers[i].handler == handler) {
+            return &serializers[i];
+        }
+    }
+    return NULL;
+}
+
+bool checkpoint_register_payload(EventHandler handler, CheckpointSave save, CheckpointLoad load) {
+    if (handler == NULL || save == NULL || load == NULL) {
+        return false;
+    }
+
+    PayloadSerializer* existing = (PayloadSerializer*)find_serializer(handler);
+    if (existing != NULL) {
+        existing->save = save;
+        existing->load = load;
+        return true;
+    }
+
+    if (serializer_count == serializer_capacity) {
+        int capacity = serializer_capacity > 0 ? serializer_capacity * 2 : 8;
+        PayloadSerializer* grown = (PayloadSerializer*)realloc(
+            serializers, (size_t)capacity * sizeof(PayloadSerializer));
+        if (grown == NULL) {
+            return false;
+        }
+        serializers = grown;
+        serializer_capacity = capacity;
+    }
+
+    serializers[serializer_count].handler = handler;
+    serializers[serializer_count].save = save;
+    serializers[serializer_count].load = load;
+    serializer_count++;
+    return true;
+}
+
+static bool write_bytes(FILE* out, const void* data, size_t size) {
+    return size == 0 || fwrite(data, size, 1, out) == 1;
+}
+
+static bool read_bytes(FILE* in, void* data, size_t size) {
+    return size == 0 || fread(data, size, 1, in) == 1;
+}
+
+static bool write_u64(FILE* out, uint64_t value) {
+    return write_bytes(out, &value, sizeof(value));
+}
+
+static bool read_u64(FILE* in, uint64_t* value) {
+    return read_bytes(in, value, sizeof(*value));
+}
+
+static bool write_u32(FILE* out, uint32_t value) {
+    return write_bytes(out, &value, sizeof(value));
+}
+
+static bool read_u32(FILE* in, uint32_t* value) {
+    return read_bytes(in, value, sizeof(*value));
+}
+
+static bool write_time(FILE* out, SimTime time) {
+    return write_bytes(out, &time, sizeof(time));
+}
+
+static bool read_time(FILE* in, SimTime* time) {
+    return read_bytes(in, time, sizeof(*time));
+}
+
+static bool write_random(FILE* out, const Random* rng) {
+    return write_u64(out, rng->state) && write_u64(out, rng->inc);
+}
+
+static bool read_random(FILE* in, Random* rng) {
+    return read_u64(in, &rng->state) && read_u64(in, &rng->inc);
+}
+
+/* A buffered global stream: whether it reseeds, else its refill point */
+typedef struct StreamPosition {
+    uint32_t reseed;
+    Random refill_rng;
+    uint32_t used;
+} StreamPosition;
+
+static bool write_global_streams(FILE* out) {
+    bool ok = true;
+    for (int kind = 0; ok && kind <= RANDOM_STREAM_NORMAL; kind++) {
+        RandomStream* stream = random_stream_global((RandomStreamKind)kind);
+        ok = write_u32(out, stream->reseed ? 1 : 0) &&
+             write_random(out, &stream->refill_rng) &&
+             write_u32(out, (uint32_t)(stream->next - stream->buffer));
+    }
+    return ok;
+}
+
+static bool read_global_streams(FILE* in, StreamPosition* positions) {
+    bool ok = true;
+    for (int kind = 0; ok && kind <= RANDOM_STREAM_NORMAL; kind++) {
+        ok = read_u32(in, &positions[kind].reseed) &&
+             read_random(in, &positions[kind].refill_rng) &&
+             read_u32(in, &positions[kind].used) &&
+             positions[kind].used <= RANDOM_STREAM_BUFFER;
+    }
+    return ok;
+}
+
+static void restore_global_streams(const StreamPosition* positions) {
+    for (int kind = 0; kind <= RANDOM_STREAM_NORMAL; kind++) {
+        RandomStream* stream = random_stream_global((RandomStreamKind)kind);
+        if (positions[kind].reseed) {
+            random_stream_discard(stream);
+        } else {
+            random_stream_seek(stream, &positions[kind].refill_rng, positions[kind].used);
+        }
+    }
+}
+
+static void collect_event(Event* event, void* context) {
+    EventList* list = (EventList*)context;
+    if (list->count == list->capacity) {
+        int capacity = list->capacity > 0 ? list->capacity * 2 : 256;
+        Event** grown = (Event**)realloc(list->events, (size_t)capacity * sizeof(Event*));
+        if (grown == NULL) {
+            list->failed = true;
+            return;
+        }
+        list->events = grown;
+        list->capacity = capacity;
+    }
+    list->events[list->count++] = event;
+}
+
+/* Dispatch order, so the file is reproducible and restore inserts in order */
+static int compare_events(const void* a, const void* b) {
+    const Event* x = *(const Event* const*)a;
+    const Event* y = *(const Event* const*)b;
+    if (x->time != y->time) {
+        return x->time < y->time ? -1 : 1;
+    }
+    return (x->sequence > y->sequence) - (x->sequence < y->sequence);
+}
+
+static bool write_event(FILE* out, const Event* event) {
+    uint32_t handler_id = event_handler_id(event->handler);
+    if (handler_id == EVENT_HANDLER_UNREGISTERED) {
+        return false;  /* Could not be bound again on restore */
+    }
+
+    uint32_t kind = PAYLOAD_NONE;
+    const PayloadSerializer* serializer = NULL;
+    if (event->payload_size > 0) {
+        kind = PAYLOAD_BYTES;
+    } else if (event->data != NULL) {
+        serializer = find_serializer(event->handler);
+        if (serializer == NULL) {
+            return false;  /* Opaque pointer */
+        }
+        kind = PAYLOAD_SERIALIZED;
+    }
+
+    if (!write_time(out, event->time) || !write_u64(out, event->sequence) ||
+        !write_u32(out, (uint32_t)event->type) || !write_u32(out, handler_id) ||
+        !write_u32(out, kind) || !write_u32(out, event->payload_size)) {
+        return false;
+    }
+
+    if (kind == PAYLOAD_BYTES) {
+        return write_bytes(out, event->data, event->payload_size);
+    }
+    if (kind == PAYLOAD_SERIALIZED) {
+        return serializer->save(out, event->data);
+    }
+    return true;
+}
+
+static bool write_checkpoint(FILE* out, Simulator* sim, Random* const* streams, int stream_count) {
+    EventList list = {NULL, 0, 0, false};
+    event_queue_for_each(sim->event_queue, collect_event, &list);
+    if (list.failed) {
+        free(list.events);
+        return false;
+    }
+    if (list.count > 0) {
+        qsort(list.events, (size_t)list.count, sizeof(Event*), compare_events);
+    }
+
+    EventQueue* queue = sim->event_queue;
+    SimStats* stats = sim->stats;
+    bool ok = write_u64(out, CHECKPOINT_MAGIC) &&
+              write_u32(out, CHECKPOINT_VERSION) &&
+              write_u32(out, CHECKPOINT_BYTE_ORDER) &&
+              write_u32(out, CHECKPOINT_TIME_FORMAT) &&
+              write_u64(out, CHECKPOINT_TIME_RESOLUTION) &&
+              write_u32(out, (uint32_t)queue->engine) &&
+              write_time(out, sim->clock->current_time) &&
+              write_time(out, sim->clock->end_time) &&
+              write_u64(out, (uint64_t)stats->total_events) &&
+              write_u64(out, (uint64_t)stats->processed_events) &&
+              write_time(out, stats->total_time) &&
+              write_time(out, stats->idle_time) &&
+              write_u64(out, sim->dispatched) &&
+              write_u64(out, queue->next_sequence) &&
+              write_u32(out, (uint32_t)queue->next_event_id) &&
+              write_random(out, random_get_global()) &&
+              write_global_streams(out) &&
+              write_u32(out, (uint32_t)stream_count);
+
+    for (int i = 0; ok && i < stream_count; i++) {
+        ok = write_random(out, streams[i]);
+    }
+
+    ok = ok && write_u64(out, (uint64_t)list.count);
+    for (int i = 0; ok && i < list.count; i++) {
+        ok = write_event(out, list.events[i]);
+    }
+    ok = ok && write_u64(out, CHECKPOINT_END);
+
+    free(list.events);
+    return ok;
+}
+
+bool simulator_checkpoint_with_streams(Simulator* sim, const char* path,
+                                       Random* const* streams, int stream_count) {
+    if (sim == NULL || path == NULL || stream_count < 0 || (stream_count > 0 && streams == NULL)) {
+        return false;
+    }
+    if (sim->processes != NULL) {
+        return false;  /* Passive ones have no event to fail on, so check here */
+    }
+
+    size_t length = strlen(path);
+    char* temp_path = (char*)malloc(length + 5);
+    if (temp_path == NULL) {
+        return false;
+    }
+    memcpy(temp_path, path, length);
+    memcpy(temp_path + length, ".tmp", 5);
+
+    FILE* out = fopen(temp_path, "wb");
+    if (out == NULL) {
+        free(temp_path);
+        return false;
+    }
+
+    bool ok = write_checkpoint(out, sim, streams, stream_count);
+    ok = (fclose(out) == 0) && ok;
+    ok = ok && rename(temp_path, path) == 0;
+    if (!ok) {
+        remove(temp_path);
+    }
+    free(temp_path);
+    return ok;
+}
+
+bool simulator_checkpoint(Simulator* sim, const char* path) {
+    return simulator_checkpoint_with_streams(sim, path, NULL, 0);
+}
+
+static bool read_event(FILE* in, Simulator* sim) {
+    SimTime time;
+    uint64_t sequence;
+    uint32_t type, handler_id, kind, payload_size;
+    if (!read_time(in, &time) || !read_u64(in, &sequence) || !read_u32(in, &type) ||
+        !read_u32(in, &handler_id) || !read_u32(in, &kind) || !read_u32(in, &payload_size)) {
+        return false;
+    }
+
+    EventHandler handler = event_handler_get(handler_id);
+    if (handler_id != 0 && handler == NULL) {
+        return false;  /* Handler not registered in this run */
+    }
+
+    Event* event = NULL;
+    if (kind == PAYLOAD_BYTES) {
+        event = simulator_create_event_with_payload(sim, time, (EventType)type, NULL,
+                                                    payload_size, handler);
+        if (event != NULL && !read_bytes(in, event->data, payload_size)) {
+            event_destroy(event);
+            return false;
+        }
+    } else if (kind == PAYLOAD_SERIALIZED) {
+        const PayloadSerializer* serializer = find_serializer(handler);
+        if (serializer == NULL) {
+            return false;
+        }
+        void* data = serializer->load(in);
+        if (data == NULL) {
+            return false;
+        }
+        event = simulator_create_event(sim, time, (EventType)type, data, handler);
+        if (event == NULL) {
+            free(data);
+            return false;
+        }
+        event->owns_data = true;
+    } else if (kind == PAYLOAD_NONE) {
+        event = simulator_create_event(sim, time, (EventType)type, NULL, handler);
+    } else {
+        return false;
+    }
+
+    if (event == NULL) {
+        return false;
+    }
+    if (!event_handle_is_valid(event_queue_schedule_with_key(sim->event_queue, event, sequence))) {
+        event_destroy(event);
+        return false;
+    }
+    return true;
+}
+
+static Simulator* read_checkpoint(FILE* in, Random* const* streams, int stream_count) {
+    uint64_t magic, resolution;
+    uint32_t version, byte_order, time_format, engine;
+    if (!read_u64(in, &magic) || magic != CHECKPOINT_MAGIC ||
+        !read_u32(in, &version) || version != CHECKPOINT_VERSION ||
+        !read_u32(in, &byte_order) || byte_order != CHECKPOINT_BYTE_ORDER ||
+        !read_u32(in, &time_format) || time_format != CHECKPOINT_TIME_FORMAT ||
+        !read_u64(in, &resolution) || resolution != CHECKPOINT_TIME_RESOLUTION ||
+        !read_u32(in, &engine) || engine > EVENT_QUEUE_CALENDAR) {
+        return NULL;
+    }
+
+    SimTime current_time, end_time, total_time, idle_time;
+    uint64_t total_events, processed_events, dispatched, next_sequence;
+    Random global_state;
+    StreamPosition positions[RANDOM_STREAM_NORMAL + 1];
+    uint32_t next_event_id, saved_streams;
+    if (!read_time(in, &current_time) || !read_time(in, &end_time) ||
+        !read_u64(in, &total_events) || !read_u64(in, &processed_events) ||
+        !read_time(in, &total_time) || !read_time(in, &idle_time) ||
+        !read_u64(in, &dispatched) || !read_u64(in, &next_sequence) ||
+        !read_u32(in, &next_event_id) ||
+        !read_random(in, &global_state) || !read_global_streams(in, positions) ||
+        !read_u32(in, &saved_streams) ||
+        saved_streams != (uint32_t)stream_count) {
+        return NULL;
+    }
+
+    /* Stage stream states so a failed restore leaves the caller's untouched */
+    Random* states = NULL;
+    if (stream_count > 0) {
+        states = (Random*)malloc((size_t)stream_count * sizeof(Random));
+        if (states == NULL) {
+            return NULL;
+        }
+    }
+    for (int i = 0; i < stream_count; i++) {
+        if (!read_random(in, &states[i])) {
+            free(states);
+            return NULL;
+        }
+    }
+
+    Simulator* sim = simulator_create_with_engine(current_time, end_time, (EventQueueEngine)engine);
+    if (sim == NULL) {
+        free(states);
+        return NULL;
+    }
+
+    uint64_t event_count;
+    bool ok = read_u64(in, &event_count);
+    for (uint64_t i = 0; ok && i < event_count; i++) {
+        ok = read_event(in, sim);
+    }
+    uint64_t end_marker;
+    ok = ok && read_u64(in, &end_marker) && end_marker == CHECKPOINT_END;
+    if (!ok) {
+        free(states);
+        simulator_destroy(sim);
+        return NULL;
+    }
+
+    sim->stats->total_events = (int)total_events;
+    sim->stats->processed_events = (int)processed_events;
+    sim->stats->total_time = total_time;
+    sim->stats->idle_time = idle_time;
+    sim->dispatched = dispatched;
+    sim->event_queue->next_sequence = next_sequence;
+    sim->event_queue->next_event_id = (int)next_event_id;  /* Past every restored id */
+
+    *random_get_global() = global_state;
+    restore_global_streams(positions);
+    for (int i = 0; i < stream_count; i++) {
+        *streams[i] = states[i];
+    }
+    free(states);
+    return sim;
+}
+
+Simulator* simulator_restore_with_streams(const char* path,
+                                          Random* const* streams, int stream_count) {
+    if (path == NULL || stream_count < 0 || (stream_count > 0 && streams == NULL)) {
+        return NULL;
+    }
+
+    FILE* in = fopen(path, "rb");
+    if (in == NULL) {
+        return NULL;
+    }
+
+    Simulator* sim = read_checkpoint(in, streams, stream_count);
+    fclose(in);
+    return sim;
+}
+
+Simulator* simulator_restore(const char* path) {
+    return simulator_restore_with_streams(path, NULL, 0);
+}
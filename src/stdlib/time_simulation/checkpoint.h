@@ -0,0 +1,54 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include "time_simulation.h"
+#include "../math/random.h"
+
+/* Checkpoint/restore of a Simulator for SIMSCRIPT.
+ *
+ * A checkpoint is a streaming binary file holding the clock, statistics,
+ * dispatch count, every pending event and the Random states (including the
+ * positions of this thread's buffered global streams), written to a
+ * temporary file and renamed into place so a crash never leaves a torn
+ * checkpoint. Event handlers are stored by registry id
+ * (event_handler_register). Payloads copied by the _with_payload
+ * constructors are stored as bytes; any other non-NULL data needs a
+ * serializer registered for the event's handler. Restored events get new
+ * ids and handles, and OutputStats attached to SimStats are not saved.
+ * Checkpoint between steps, not from inside a handler.
+ *
+ * Processes (process.h) are not saved: their bodies, locals and resource
+ * waits have no serialized form, so checkpointing a simulator with live
+ * processes fails. */
+
+/* Writes data to out; returns false on failure */
+typedef bool (*CheckpointSave)(FILE* out, const void* data);
+
+/* Reads data written by the matching CheckpointSave; the result must come
+ * from malloc and is freed with the event */
+typedef void* (*CheckpointLoad)(FILE* in);
+
+/* Serializer for the data of events dispatched to handler */
+bool checkpoint_register_payload(EventHandler handler, CheckpointSave save, CheckpointLoad load);
+
+/* Save sim and this thread's global Random state; false on a write error,
+ * an unregistered handler or opaque data, or live processes */
+bool simulator_checkpoint(Simulator* sim, const char* path);
+
+/* Rebuild a simulator and restore this thread's global Random state;
+ * NULL if the file is missing, corrupt or from an incompatible build */
+Simulator* simulator_restore(const char* path);
+
+/* Variants that also save and restore the given model streams, in order */
+bool simulator_checkpoint_with_streams(Simulator* sim, const char* path,
+                                       Random* const* streams, int stream_count);
+Simulator* simulator_restore_with_streams(const char* path,
+                                          Random* const* streams, int stream_count);
+
+#ifdef __cplusplus
+}
+#endif
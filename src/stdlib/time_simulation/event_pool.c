@@ -0,0 +1,106 @@
+#include "time_simulation.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define EVENT_POOL_CACHE_LINE 64
+#define EVENT_POOL_DEFAULT_SLAB 1024
+
+static bool event_pool_grow(EventPool* pool) {
+    if (pool->slab_count == pool->slab_capacity) {
+        int new_capacity = pool->slab_capacity > 0 ? pool->slab_capacity * 2 : 8;
+        void** slabs = (void**)realloc(pool->slabs, (size_t)new_capacity * sizeof(void*));
+        if (slabs == NULL) {
+            return false;
+        }
+        pool->slabs = slabs;
+        pool->slab_capacity = new_capacity;
+    }
+
+    char* slab = (char*)aligned_alloc(EVENT_POOL_CACHE_LINE,
+                                      pool->slot_size * (size_t)pool->events_per_slab);
+    if (slab == NULL) {
+        return false;
+    }
+    pool->slabs[pool->slab_count++] = slab;
+
+    /* Thread the new slots onto the free list in address order */
+    for (int i = pool->events_per_slab - 1; i >= 0; i--) {
+        Event* event = (Event*)(slab + (size_t)i * pool->slot_size);
+        event->next = pool->free_list;
+        pool->free_list = event;
+    }
+    return true;
+}
+
+EventPool* event_pool_create(int events_per_slab) {
+    EventPool* pool = (EventPool*)malloc(sizeof(EventPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    pool->slabs = NULL;
+    pool->slab_count = 0;
+    pool->slab_capacity = 0;
+    pool->events_per_slab = events_per_slab > 0 ? events_per_slab : EVENT_POOL_DEFAULT_SLAB;
+    pool->slot_size = (sizeof(Event) + EVENT_POOL_CACHE_LINE - 1) &
+                      ~(size_t)(EVENT_POOL_CACHE_LINE - 1);
+    pool->free_list = NULL;
+    pool->in_use = 0;
+    pool->high_water = 0;
+    pool->total_allocations = 0;
+    return pool;
+}
+
+void event_pool_destroy(EventPool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < pool->slab_count; i++) {
+        free(pool->slabs[i]);
+    }
+    free(pool->slabs);
+    free(pool);
+}
+
+Event* event_pool_alloc(EventPool* pool) {
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    if (pool->free_list == NULL && !event_pool_grow(pool)) {
+        return NULL;
+    }
+
+    Event* event = pool->free_list;
+    pool->free_list = event->next;
+
+    memset(event, 0, sizeof(Event));
+    event->handle_index = EVENT_HANDLE_INVALID_INDEX;
+    event->pool = pool;
+
+    pool->in_use++;
+    pool->total_allocations++;
+    if (pool->in_use > pool->high_water) {
+        pool->high_water = pool->in_use;
+    }
+    return event;
+}
+
+void event_pool_free(EventPool* pool, Event* event) {
+    if (pool == NULL || event == NULL) {
+        return;
+    }
+
+    event->next = pool->free_list;
+    pool->free_list = event;
+    pool->in_use--;
+}
+
+size_t event_pool_in_use(EventPool* pool) {
+    return (pool != NULL) ? pool->in_use : 0;
+}
+
+size_t event_pool_high_water(EventPool* pool) {
+    return (pool != NULL) ? pool->high_water : 0;
+}
@@ -0,0 +1,951 @@
+#include "time_simulation.h"
+#include "sim_counters.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define EVENT_QUEUE_INITIAL_CAPACITY 64
+#define EVENT_QUEUE_CACHE_LINE 64
+#define EVENT_QUEUE_INITIAL_SLOTS 64
+#define CALENDAR_MIN_BUCKETS 2
+#define CALENDAR_MAX_SAMPLE 25
+
+/* Tombstones are purged once they outnumber live events (and exceed a floor) */
+#define COMPACT_MIN_DEAD 64
+
+/* Ordering shared by all engines: earlier time first, then insertion order */
+static inline bool key_before(const EventQueueKey* a, const EventQueueKey* b) {
+    return a->time < b->time || (a->time == b->time && a->sequence < b->sequence);
+}
+
+static inline bool event_before(const Event* a, const Event* b) {
+    return a->time < b->time || (a->time == b->time && a->sequence < b->sequence);
+}
+
+/* Heap engines (binary and 4-ary share one implementation). Logical index i
+ * is stored at physical slot i + arity - 1, which places each sibling group
+ * (children arity*i+1 .. arity*i+arity) on an aligned boundary: with 16-byte
+ * keys the four children of a 4-ary node occupy exactly one cache line. */
+static inline int heap_arity(const EventQueue* queue) {
+    return queue->engine == EVENT_QUEUE_QUATERNARY_HEAP ? 4 : 2;
+}
+
+static bool heap_reserve(EventQueue* queue, int needed) {
+    if (needed <= queue->capacity) {
+        return true;
+    }
+
+    int new_capacity = queue->capacity > 0 ? queue->capacity : EVENT_QUEUE_INITIAL_CAPACITY;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+
+    int offset = heap_arity(queue) - 1;
+    size_t bytes = (size_t)(new_capacity + offset) * sizeof(EventQueueKey);
+    bytes = (bytes + EVENT_QUEUE_CACHE_LINE - 1) & ~(size_t)(EVENT_QUEUE_CACHE_LINE - 1);
+    EventQueueKey* storage = (EventQueueKey*)aligned_alloc(EVENT_QUEUE_CACHE_LINE, bytes);
+    Event** events = (Event**)realloc(queue->events, (size_t)new_capacity * sizeof(Event*));
+    if (storage == NULL || events == NULL) {
+        free(storage);
+        if (events != NULL) {
+            queue->events = events;
+        }
+        return false;
+    }
+
+    EventQueueKey* keys = storage + offset;
+    if (queue->keys != NULL) {
+        memcpy(keys, queue->keys, (size_t)queue->count * sizeof(EventQueueKey));
+        free(queue->key_storage);
+    }
+
+    queue->key_storage = storage;
+    queue->keys = keys;
+    queue->events = events;
+    queue->capacity = new_capacity;
+    return true;
+}
+
+static inline void heap_sift_up(EventQueue* queue, int index, int arity) {
+    EventQueueKey* keys = queue->keys;
+    Event** events = queue->events;
+    EventQueueKey moving = keys[index];
+    Event* moving_event = events[index];
+    while (index > 0) {
+        int parent = (index - 1) / arity;
+        if (!key_before(&moving, &keys[parent])) {
+            break;
+        }
+        keys[index] = keys[parent];
+        events[index] = events[parent];
+        index = parent;
+        SIM_COUNT(queue->schedule_steps++);
+    }
+    keys[index] = moving;
+    events[index] = moving_event;
+}
+
+static inline void heap_sift_down(EventQueueKey* keys, Event** events, int count,
+                                  int index, int arity) {
+    EventQueueKey moving = keys[index];
+    Event* moving_event = events[index];
+    while (1) {
+        int first = index * arity + 1;
+        if (first >= count) {
+            break;
+        }
+
+        int last = first + arity < count ? first + arity : count;
+        int best = first;
+        for (int child = first + 1; child < last; child++) {
+            if (key_before(&keys[child], &keys[best])) {
+                best = child;
+            }
+        }
+
+        if (!key_before(&keys[best], &moving)) {
+            break;
+        }
+        keys[index] = keys[best];
+        events[index] = events[best];
+        index = best;
+    }
+    keys[index] = moving;
+    events[index] = moving_event;
+}
+
+static bool heap_push(EventQueue* queue, Event* event) {
+    if (!heap_reserve(queue, queue->count + 1)) {
+        return false;
+    }
+
+    int index = queue->count++;
+    queue->keys[index].time = event->time;
+    queue->keys[index].sequence = event->sequence;
+    queue->events[index] = event;
+
+    if (heap_arity(queue) == 4) {
+        heap_sift_up(queue, index, 4);
+    } else {
+        heap_sift_up(queue, index, 2);
+    }
+    return true;
+}
+
+static Event* heap_pop(EventQueue* queue) {
+    Event* event = queue->events[0];
+    queue->count--;
+
+    if (queue->count > 0) {
+        queue->keys[0] = queue->keys[queue->count];
+        queue->events[0] = queue->events[queue->count];
+        if (heap_arity(queue) == 4) {
+            heap_sift_down(queue->keys, queue->events, queue->count, 0, 4);
+        } else {
+            heap_sift_down(queue->keys, queue->events, queue->count, 0, 2);
+        }
+    }
+
+    return event;
+}
+
+/* Drops cancelled entries and rebuilds the heap bottom-up in O(n) */
+static void heap_compact(EventQueue* queue) {
+    int live = 0;
+    for (int i = 0; i < queue->count; i++) {
+        Event* event = queue->events[i];
+        if (event->cancelled) {
+            event_destroy(event);
+        } else {
+            queue->keys[live] = queue->keys[i];
+            queue->events[live] = event;
+            live++;
+        }
+    }
+    queue->count = live;
+
+    int arity = heap_arity(queue);
+    for (int i = (live - 2) / arity; i >= 0 && live > 1; i--) {
+        heap_sift_down(queue->keys, queue->events, live, i, arity);
+    }
+}
+
+/* Pairing heap engine: events are linked through child/next/prev */
+static Event* pairing_meld(Event* a, Event* b) {
+    if (a == NULL) {
+        return b;
+    }
+    if (b == NULL) {
+        return a;
+    }
+
+    if (event_before(b, a)) {
+        Event* tmp = a;
+        a = b;
+        b = tmp;
+    }
+
+    /* b becomes the first child of a */
+    b->prev = a;
+    b->next = a->child;
+    if (a->child != NULL) {
+        a->child->prev = b;
+    }
+    a->child = b;
+    a->next = NULL;
+    a->prev = NULL;
+    return a;
+}
+
+/* Two-pass merge of a sibling list into a single heap */
+static Event* pairing_merge_siblings(Event* first) {
+    if (first == NULL) {
+        return NULL;
+    }
+
+    /* First pass: meld pairs left to right, chaining results through prev */
+    Event* merged = NULL;
+    while (first != NULL) {
+        Event* a = first;
+        Event* b = a->next;
+        first = (b != NULL) ? b->next : NULL;
+
+        a->next = NULL;
+        a->prev = NULL;
+        if (b != NULL) {
+            b->next = NULL;
+            b->prev = NULL;
+        }
+
+        Event* pair = pairing_meld(a, b);
+        pair->prev = merged;
+        merged = pair;
+    }
+
+    /* Second pass: meld right to left */
+    Event* result = merged;
+    merged = merged->prev;
+    result->prev = NULL;
+    while (merged != NULL) {
+        Event* next = merged->prev;
+        merged->prev = NULL;
+        result = pairing_meld(merged, result);
+        merged = next;
+    }
+
+    return result;
+}
+
+static Event* pairing_pop(EventQueue* queue) {
+    Event* event = queue->head;
+    queue->head = pairing_merge_siblings(event->child);
+    queue->count--;
+
+    event->child = NULL;
+    event->next = NULL;
+    event->prev = NULL;
+    return event;
+}
+
+/* Unlinks every node of the heap into one list chained through next,
+ * splicing each child list onto the work list as it is reached */
+static Event* pairing_flatten(Event* root) {
+    Event* list = NULL;
+    Event* work = root;
+    while (work != NULL) {
+        Event* node = work;
+        work = node->next;
+
+        Event* child = node->child;
+        if (child != NULL) {
+            Event* tail = child;
+            while (tail->next != NULL) {
+                tail = tail->next;
+            }
+            tail->next = work;
+            work = child;
+        }
+
+        node->child = NULL;
+        node->prev = NULL;
+        node->next = list;
+        list = node;
+    }
+    return list;
+}
+
+static void pairing_compact(EventQueue* queue) {
+    Event* list = pairing_flatten(queue->head);
+    queue->head = NULL;
+    queue->count = 0;
+
+    while (list != NULL) {
+        Event* node = list;
+        list = node->next;
+        node->next = NULL;
+
+        if (node->cancelled) {
+            event_destroy(node);
+        } else {
+            queue->head = pairing_meld(queue->head, node);
+            queue->count++;
+        }
+    }
+}
+
+/* Calendar queue engine (Brown, 1988). Each bucket covers one "day" of
+ * bucket_width time units; a year is bucket_count days. Buckets hold lists
+ * sorted by (time, sequence) with a tail pointer so FIFO appends are O(1). */
+static inline int64_t calendar_vbucket(const EventQueue* queue, SimTime time) {
+#ifdef SIM_TIME_INTEGER
+    int64_t vbucket = time / queue->bucket_width;
+    return (time % queue->bucket_width < 0) ? vbucket - 1 : vbucket;
+#else
+    return (int64_t)floor(time / queue->bucket_width);
+#endif
+}
+
+static inline int calendar_index(const EventQueue* queue, int64_t vbucket) {
+    return (int)(vbucket & (int64_t)(queue->bucket_count - 1));
+}
+
+static bool calendar_alloc_buckets(EventQueue* queue, int bucket_count) {
+    Event** buckets = (Event**)calloc((size_t)bucket_count, sizeof(Event*));
+    Event** tails = (Event**)calloc((size_t)bucket_count, sizeof(Event*));
+    if (buckets == NULL || tails == NULL) {
+        free(buckets);
+        free(tails);
+        return false;
+    }
+
+    free(queue->buckets);
+    free(queue->bucket_tails);
+    queue->buckets = buckets;
+    queue->bucket_tails = tails;
+    queue->bucket_count = bucket_count;
+    return true;
+}
+
+static void calendar_insert(EventQueue* queue, Event* event) {
+    int64_t vbucket = calendar_vbucket(queue, event->time);
+    int index = calendar_index(queue, vbucket);
+    Event* tail = queue->bucket_tails[index];
+
+    if (tail == NULL) {
+        event->next = NULL;
+        queue->buckets[index] = event;
+        queue->bucket_tails[index] = event;
+    } else if (!event_before(event, tail)) {
+        event->next = NULL;
+        tail->next = event;
+        queue->bucket_tails[index] = event;
+    } else if (event_before(event, queue->buckets[index])) {
+        event->next = queue->buckets[index];
+        queue->buckets[index] = event;
+    } else {
+        Event* current = queue->buckets[index];
+        while (!event_before(event, current->next)) {
+            current = current->next;
+            SIM_COUNT(queue->schedule_steps++);
+        }
+        event->next = current->next;
+        current->next = event;
+    }
+
+    if (vbucket < queue->current_bucket) {
+        queue->current_bucket = vbucket;
+    }
+}
+
+/* Locates the bucket holding the earliest event, advancing current_bucket */
+static int calendar_find_min(EventQueue* queue) {
+    for (int i = 0; i < queue->bucket_count; i++) {
+        int index = calendar_index(queue, queue->current_bucket);
+        Event* head = queue->buckets[index];
+        if (head != NULL && calendar_vbucket(queue, head->time) <= queue->current_bucket) {
+            return index;
+        }
+        queue->current_bucket++;
+    }
+
+    /* Nothing due within a full year: jump straight to the earliest head */
+    int best = -1;
+    for (int i = 0; i < queue->bucket_count; i++) {
+        Event* head = queue->buckets[i];
+        if (head != NULL && (best < 0 || event_before(head, queue->buckets[best]))) {
+            best = i;
+        }
+    }
+    if (best >= 0) {
+        queue->current_bucket = calendar_vbucket(queue, queue->buckets[best]->time);
+    }
+    return best;
+}
+
+static Event* calendar_pop_bucket(EventQueue* queue, int index) {
+    Event* event = queue->buckets[index];
+    queue->buckets[index] = event->next;
+    if (event->next == NULL) {
+        queue->bucket_tails[index] = NULL;
+    }
+    event->next = NULL;
+    return event;
+}
+
+/* Estimates a bucket width from the spacing of the events at the front of
+ * the queue: three times the mean separation, ignoring outliers. */
+static SimTime calendar_sample_width(EventQueue* queue) {
+    int total = queue->count;
+    if (total < 2) {
+        return queue->bucket_width;
+    }
+
+    int samples = total <= 5 ? total : 5 + total / 10;
+    if (samples > CALENDAR_MAX_SAMPLE) {
+        samples = CALENDAR_MAX_SAMPLE;
+    }
+
+    Event* front[CALENDAR_MAX_SAMPLE];
+    for (int i = 0; i < samples; i++) {
+        front[i] = calendar_pop_bucket(queue, calendar_find_min(queue));
+    }
+
+    double mean_gap = (double)(front[samples - 1]->time - front[0]->time) / (samples - 1);
+    double gap_sum = 0.0;
+    int gap_count = 0;
+    for (int i = 1; i < samples; i++) {
+        double gap = (double)(front[i]->time - front[i - 1]->time);
+        if (gap < 2.0 * mean_gap) {
+            gap_sum += gap;
+            gap_count++;
+        }
+    }
+
+    for (int i = samples - 1; i >= 0; i--) {
+        calendar_insert(queue, front[i]);
+    }
+
+    double width = gap_count > 0 ? 3.0 * gap_sum / gap_count : 0.0;
+#ifdef SIM_TIME_INTEGER
+    width = ceil(width);  /* Integer time must not get a zero width */
+#endif
+    return width > 0.0 ? (SimTime)width : queue->bucket_width;
+}
+
+static void calendar_resize(EventQueue* queue, int bucket_count) {
+    if (!queue->resize_enabled) {
+        return;
+    }
+
+    queue->resize_enabled = false;
+    SimTime width = calendar_sample_width(queue);
+
+    /* Unhook every event into one list, then rehash into the new calendar */
+    Event* all = NULL;
+    for (int i = 0; i < queue->bucket_count; i++) {
+        if (queue->buckets[i] != NULL) {
+            queue->bucket_tails[i]->next = all;
+            all = queue->buckets[i];
+        }
+    }
+
+    Event** old_buckets = queue->buckets;
+    Event** old_tails = queue->bucket_tails;
+    queue->buckets = NULL;
+    queue->bucket_tails = NULL;
+    if (!calendar_alloc_buckets(queue, bucket_count)) {
+        /* Keep the old geometry; only the contents need re-threading */
+        queue->buckets = old_buckets;
+        queue->bucket_tails = old_tails;
+        memset(queue->buckets, 0, (size_t)queue->bucket_count * sizeof(Event*));
+        memset(queue->bucket_tails, 0, (size_t)queue->bucket_count * sizeof(Event*));
+        width = queue->bucket_width;
+    } else {
+        free(old_buckets);
+        free(old_tails);
+    }
+
+    queue->bucket_width = width;
+    queue->current_bucket = INT64_MAX;
+    while (all != NULL) {
+        Event* next = all->next;
+        calendar_insert(queue, all);
+        all = next;
+    }
+    if (queue->current_bucket == INT64_MAX) {
+        queue->current_bucket = 0;
+    }
+
+    queue->resize_enabled = true;
+}
+
+static void calendar_push(EventQueue* queue, Event* event) {
+    calendar_insert(queue, event);
+    queue->count++;
+
+    if (queue->count > 2 * queue->bucket_count) {
+        calendar_resize(queue, queue->bucket_count * 2);
+    }
+}
+
+static Event* calendar_pop(EventQueue* queue) {
+    Event* event = calendar_pop_bucket(queue, calendar_find_min(queue));
+    queue->count--;
+
+    if (queue->bucket_count > CALENDAR_MIN_BUCKETS && queue->count < queue->bucket_count / 2) {
+        calendar_resize(queue, queue->bucket_count / 2);
+    }
+    return event;
+}
+
+static void calendar_compact(EventQueue* queue) {
+    for (int i = 0; i < queue->bucket_count; i++) {
+        Event* previous = NULL;
+        Event* current = queue->buckets[i];
+        while (current != NULL) {
+            Event* next = current->next;
+            if (!current->cancelled) {
+                previous = current;
+            } else {
+                if (previous == NULL) {
+                    queue->buckets[i] = next;
+                } else {
+                    previous->next = next;
+                }
+                event_destroy(current);
+                queue->count--;
+            }
+            current = next;
+        }
+        queue->bucket_tails[i] = previous;
+    }
+}
+
+/* Sorted list engine */
+static void list_push(EventQueue* queue, Event* event) {
+    if (queue->head == NULL || event_before(event, queue->head)) {
+        event->next = queue->head;
+        queue->head = event;
+    } else {
+        Event* current = queue->head;
+        while (current->next != NULL && !event_before(event, current->next)) {
+            current = current->next;
+            SIM_COUNT(queue->schedule_steps++);
+        }
+        event->next = current->next;
+        current->next = event;
+    }
+
+    queue->count++;
+}
+
+static Event* list_pop(EventQueue* queue) {
+    Event* event = queue->head;
+    queue->head = event->next;
+    queue->count--;
+
+    event->next = NULL;
+    return event;
+}
+
+static void list_compact(EventQueue* queue) {
+    Event** link = &queue->head;
+    while (*link != NULL) {
+        Event* current = *link;
+        if (current->cancelled) {
+            *link = current->next;
+            event_destroy(current);
+            queue->count--;
+        } else {
+            link = &current->next;
+        }
+    }
+}
+
+/* Engine dispatch */
+static bool engine_push(EventQueue* queue, Event* event) {
+    switch (queue->engine) {
+        case EVENT_QUEUE_BINARY_HEAP:
+        case EVENT_QUEUE_QUATERNARY_HEAP:
+            return heap_push(queue, event);
+        case EVENT_QUEUE_PAIRING_HEAP:
+            queue->head = pairing_meld(queue->head, event);
+            queue->count++;
+            return true;
+        case EVENT_QUEUE_CALENDAR:
+            calendar_push(queue, event);
+            return true;
+        case EVENT_QUEUE_SORTED_LIST:
+        default:
+            list_push(queue, event);
+            return true;
+    }
+}
+
+static Event* engine_pop(EventQueue* queue) {
+    switch (queue->engine) {
+        case EVENT_QUEUE_BINARY_HEAP:
+        case EVENT_QUEUE_QUATERNARY_HEAP:
+            return heap_pop(queue);
+        case EVENT_QUEUE_PAIRING_HEAP:
+            return pairing_pop(queue);
+        case EVENT_QUEUE_CALENDAR:
+            return calendar_pop(queue);
+        case EVENT_QUEUE_SORTED_LIST:
+        default:
+            return list_pop(queue);
+    }
+}
+
+static Event* engine_peek(EventQueue* queue) {
+    switch (queue->engine) {
+        case EVENT_QUEUE_BINARY_HEAP:
+        case EVENT_QUEUE_QUATERNARY_HEAP:
+            return queue->events[0];
+        case EVENT_QUEUE_CALENDAR:
+            return queue->buckets[calendar_find_min(queue)];
+        case EVENT_QUEUE_PAIRING_HEAP:
+        case EVENT_QUEUE_SORTED_LIST:
+        default:
+            return queue->head;
+    }
+}
+
+static void engine_compact(EventQueue* queue) {
+    switch (queue->engine) {
+        case EVENT_QUEUE_BINARY_HEAP:
+        case EVENT_QUEUE_QUATERNARY_HEAP:
+            heap_compact(queue);
+            break;
+        case EVENT_QUEUE_PAIRING_HEAP:
+            pairing_compact(queue);
+            break;
+        case EVENT_QUEUE_CALENDAR:
+            calendar_compact(queue);
+            break;
+        case EVENT_QUEUE_SORTED_LIST:
+        default:
+            list_compact(queue);
+            break;
+    }
+    queue->dead_count = 0;
+}
+
+static void engine_destroy_all(EventQueue* queue) {
+    switch (queue->engine) {
+        case EVENT_QUEUE_BINARY_HEAP:
+        case EVENT_QUEUE_QUATERNARY_HEAP:
+            for (int i = 0; i < queue->count; i++) {
+                event_destroy(queue->events[i]);
+            }
+            break;
+        case EVENT_QUEUE_PAIRING_HEAP: {
+            Event* list = pairing_flatten(queue->head);
+            while (list != NULL) {
+                Event* next = list->next;
+                event_destroy(list);
+                list = next;
+            }
+            break;
+        }
+        case EVENT_QUEUE_CALENDAR:
+            for (int i = 0; i < queue->bucket_count; i++) {
+                Event* current = queue->buckets[i];
+                while (current != NULL) {
+                    Event* next = current->next;
+                    event_destroy(current);
+                    current = next;
+                }
+            }
+            break;
+        case EVENT_QUEUE_SORTED_LIST:
+        default: {
+            Event* current = queue->head;
+            while (current != NULL) {
+                Event* next = current->next;
+                event_destroy(current);
+                current = next;
+            }
+            break;
+        }
+    }
+    queue->head = NULL;
+    queue->count = 0;
+    queue->dead_count = 0;
+}
+
+/* Handle table */
+static uint32_t slot_acquire(EventQueue* queue, Event* event) {
+    if (queue->free_slot == EVENT_HANDLE_INVALID_INDEX) {
+        uint32_t old_capacity = queue->slot_capacity;
+        uint32_t new_capacity = old_capacity > 0 ? old_capacity * 2 : EVENT_QUEUE_INITIAL_SLOTS;
+        EventQueueSlot* slots = (EventQueueSlot*)realloc(queue->slots,
+                                                         new_capacity * sizeof(EventQueueSlot));
+        if (slots == NULL) {
+            return EVENT_HANDLE_INVALID_INDEX;
+        }
+
+        for (uint32_t i = old_capacity; i < new_capacity; i++) {
+            slots[i].event = NULL;
+            slots[i].generation = 0;
+            slots[i].next_free = (i + 1 < new_capacity) ? i + 1 : EVENT_HANDLE_INVALID_INDEX;
+        }
+        queue->slots = slots;
+        queue->slot_capacity = new_capacity;
+        queue->free_slot = old_capacity;
+    }
+
+    uint32_t index = queue->free_slot;
+    EventQueueSlot* slot = &queue->slots[index];
+    queue->free_slot = slot->next_free;
+    slot->event = event;
+    return index;
+}
+
+static void slot_release(EventQueue* queue, uint32_t index) {
+    EventQueueSlot* slot = &queue->slots[index];
+    slot->event = NULL;
+    slot->generation++;
+    slot->next_free = queue->free_slot;
+    queue->free_slot = index;
+}
+
+/* Marks a scheduled event dead; the engine drops it lazily */
+static void tombstone(EventQueue* queue, Event* event) {
+    slot_release(queue, event->handle_index);
+    event->handle_index = EVENT_HANDLE_INVALID_INDEX;
+    event->cancelled = true;
+    if (event->in_batch) {
+        return;  /* Already out of the engine; the batch owner frees it */
+    }
+    queue->dead_count++;
+
+    if (queue->dead_count >= COMPACT_MIN_DEAD && queue->dead_count * 2 > queue->count) {
+        engine_compact(queue);
+    }
+}
+
+/* Removes tombstones sitting at the front of the queue */
+static void skip_cancelled(EventQueue* queue) {
+    while (queue->count > 0) {
+        Event* front = engine_peek(queue);
+        if (!front->cancelled) {
+            return;
+        }
+        engine_pop(queue);
+        queue->dead_count--;
+        event_destroy(front);
+    }
+}
+
+/* Event queue implementation */
+EventQueue* event_queue_create(void) {
+    return event_queue_create_with_engine(EVENT_QUEUE_DEFAULT_ENGINE);
+}
+
+EventQueue* event_queue_create_with_engine(EventQueueEngine engine) {
+    EventQueue* queue = (EventQueue*)malloc(sizeof(EventQueue));
+    if (queue == NULL) {
+        return NULL;
+    }
+
+    queue->engine = engine;
+    queue->head = NULL;
+    queue->keys = NULL;
+    queue->events = NULL;
+    queue->key_storage = NULL;
+    queue->capacity = 0;
+    queue->count = 0;
+    queue->dead_count = 0;
+    queue->next_sequence = 0;
+    queue->next_event_id = 1;
+    queue->slots = NULL;
+    queue->slot_capacity = 0;
+    queue->free_slot = EVENT_HANDLE_INVALID_INDEX;
+    queue->buckets = NULL;
+    queue->bucket_tails = NULL;
+    queue->bucket_count = 0;
+    queue->bucket_width = sim_time_from_double(1.0);
+    queue->current_bucket = 0;
+    queue->resize_enabled = true;
+    SIM_COUNT(queue->schedule_calls = 0);
+    SIM_COUNT(queue->schedule_steps = 0);
+
+    if (engine == EVENT_QUEUE_CALENDAR &&
+        !calendar_alloc_buckets(queue, CALENDAR_MIN_BUCKETS)) {
+        free(queue);
+        return NULL;
+    }
+    return queue;
+}
+
+void event_queue_destroy(EventQueue* queue) {
+    if (queue == NULL) {
+        return;
+    }
+
+    engine_destroy_all(queue);
+    free(queue->key_storage);
+    free(queue->events);
+    free(queue->slots);
+    free(queue->buckets);
+    free(queue->bucket_tails);
+    free(queue);
+}
+
+bool event_queue_is_empty(EventQueue* queue) {
+    return queue == NULL || queue->count == queue->dead_count;
+}
+
+int event_queue_size(EventQueue* queue) {
+    return (queue != NULL) ? queue->count - queue->dead_count : 0;
+}
+
+EventHandle event_queue_schedule(EventQueue* queue, Event* event) {
+    if (queue == NULL) {
+        EventHandle invalid = {EVENT_HANDLE_INVALID_INDEX, 0};
+        return invalid;
+    }
+    return event_queue_schedule_with_key(queue, event, queue->next_sequence++);
+}
+
+EventHandle event_queue_schedule_with_key(EventQueue* queue, Event* event, uint64_t sequence) {
+    EventHandle handle = {EVENT_HANDLE_INVALID_INDEX, 0};
+    if (queue == NULL || event == NULL) {
+        return handle;
+    }
+
+    uint32_t index = slot_acquire(queue, event);
+    if (index == EVENT_HANDLE_INVALID_INDEX) {
+        return handle;
+    }
+
+    event->event_id = queue->next_event_id++;
+    event->sequence = sequence;
+    event->handle_index = index;
+    event->cancelled = false;
+    event->in_batch = false;
+    event->next = NULL;
+    event->child = NULL;
+    event->prev = NULL;
+
+    SIM_COUNT(queue->schedule_calls++);
+    if (!engine_push(queue, event)) {
+        slot_release(queue, index);
+        event->handle_index = EVENT_HANDLE_INVALID_INDEX;
+        return handle;
+    }
+
+    handle.index = index;
+    handle.generation = queue->slots[index].generation;
+    return handle;
+}
+
+Event* event_queue_next(EventQueue* queue) {
+    if (event_queue_is_empty(queue)) {
+        return NULL;
+    }
+
+    skip_cancelled(queue);
+    Event* event = engine_pop(queue);
+    slot_release(queue, event->handle_index);
+    event->handle_index = EVENT_HANDLE_INVALID_INDEX;
+    return event;
+}
+
+Event* event_queue_peek(EventQueue* queue) {
+    if (event_queue_is_empty(queue)) {
+        return NULL;
+    }
+
+    skip_cancelled(queue);
+    return engine_peek(queue);
+}
+
+int event_queue_next_batch(EventQueue* queue, Event** batch, int max_events, SimTime window) {
+    if (batch == NULL || max_events <= 0 || event_queue_is_empty(queue)) {
+        return 0;
+    }
+
+    skip_cancelled(queue);
+    SimTime limit = engine_peek(queue)->time + window;
+
+    int taken = 0;
+    while (taken < max_events && !event_queue_is_empty(queue)) {
+        skip_cancelled(queue);
+        Event* front = engine_peek(queue);
+        if (front->time > limit) {
+            break;
+        }
+
+        engine_pop(queue);
+        front->in_batch = true;
+        batch[taken++] = front;
+    }
+    return taken;
+}
+
+void event_queue_complete(EventQueue* queue, Event* event) {
+    if (queue == NULL || event == NULL || !event->in_batch) {
+        return;
+    }
+
+    event->in_batch = false;
+    if (event->handle_index != EVENT_HANDLE_INVALID_INDEX) {
+        slot_release(queue, event->handle_index);
+        event->handle_index = EVENT_HANDLE_INVALID_INDEX;
+    }
+}
+
+void event_queue_cancel(EventQueue* queue, int event_id) {
+    if (event_queue_is_empty(queue)) {
+        return;
+    }
+
+    /* Every live event owns a slot, so the table is a complete index */
+    for (uint32_t i = 0; i < queue->slot_capacity; i++) {
+        Event* event = queue->slots[i].event;
+        if (event != NULL && event->event_id == event_id) {
+            tombstone(queue, event);
+            return;
+        }
+    }
+}
+
+bool event_queue_cancel_handle(EventQueue* queue, EventHandle handle) {
+    Event* event = event_queue_lookup(queue, handle);
+    if (event == NULL) {
+        return false;
+    }
+
+    tombstone(queue, event);
+    return true;
+}
+
+Event* event_queue_lookup(EventQueue* queue, EventHandle handle) {
+    if (queue == NULL || handle.index >= queue->slot_capacity) {
+        return NULL;
+    }
+
+    EventQueueSlot* slot = &queue->slots[handle.index];
+    return (slot->generation == handle.generation) ? slot->event : NULL;
+}
+
+bool event_handle_is_valid(EventHandle handle) {
+    return handle.index != EVENT_HANDLE_INVALID_INDEX;
+}
+
+void event_queue_for_each(EventQueue* queue, void (*visit)(Event* event, void* context),
+                          void* context) {
+    if (queue == NULL || visit == NULL) {
+        return;
+    }
+
+    /* Every scheduled event holds a handle slot, whatever the engine */
+    for (uint32_t i = 0; i < queue->slot_capacity; i++) {
+        Event* event = queue->slots[i].event;
+        if (event != NULL && !event->in_batch) {
+            visit(event, context);
+        }
+    }
+}
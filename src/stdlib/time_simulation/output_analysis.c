@@ -0,0 +1,286 @@
+#include "output_analysis.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static double initial_batch_weight(OutputKind kind, double interval) {
+    if (kind == OUTPUT_OBSERVATION) {
+        return OUTPUT_MSER_BATCH;
+    }
+    return interval > 0.0 ? interval : 1.0;
+}
+
+OutputStat* output_stat_create(const char* name, OutputKind kind, double interval) {
+    OutputStat* stat = (OutputStat*)malloc(sizeof(OutputStat));
+    if (stat == NULL) {
+        return NULL;
+    }
+
+    const char* label = (name != NULL) ? name : "";
+    stat->name = (char*)malloc(strlen(label) + 1);
+    if (stat->name == NULL) {
+        free(stat);
+        return NULL;
+    }
+    strcpy(stat->name, label);
+
+    stat->kind = kind;
+    stat->value = 0.0;
+    stat->initial_batch_weight = initial_batch_weight(kind, interval);
+    output_stat_reset(stat, SIM_TIME_ZERO);
+    return stat;
+}
+
+void output_stat_destroy(OutputStat* stat) {
+    if (stat != NULL) {
+        free(stat->name);
+        free(stat);
+    }
+}
+
+void output_stat_reset(OutputStat* stat, SimTime time) {
+    if (stat == NULL) {
+        return;
+    }
+
+    stat->count = 0;
+    stat->total_weight = 0.0;
+    stat->mean = 0.0;
+    stat->m2 = 0.0;
+    stat->min = HUGE_VAL;
+    stat->max = -HUGE_VAL;
+    stat->last_time = time;
+    stat->batch_count = 0;
+    stat->batch_weight = stat->initial_batch_weight;  /* Undo any merging */
+    stat->pending_sum = 0.0;
+    stat->pending_weight = 0.0;
+}
+
+/* West's weighted update of the running moments */
+static void accumulate_moments(OutputStat* stat, double value, double weight) {
+    if (value < stat->min) {
+        stat->min = value;
+    }
+    if (value > stat->max) {
+        stat->max = value;
+    }
+
+    double total = stat->total_weight + weight;
+    double delta = value - stat->mean;
+    stat->mean += delta * weight / total;
+    stat->m2 += weight * delta * (value - stat->mean);
+    stat->total_weight = total;
+}
+
+/* Halve the number of batches by averaging neighbours */
+static void merge_batches(OutputStat* stat) {
+    int merged = stat->batch_count / 2;
+    for (int i = 0; i < merged; i++) {
+        stat->batches[i] = 0.5 * (stat->batches[2 * i] + stat->batches[2 * i + 1]);
+    }
+    stat->batch_count = merged;
+    stat->batch_weight *= 2.0;
+}
+
+static void close_batch(OutputStat* stat) {
+    stat->batches[stat->batch_count++] = stat->pending_sum / stat->batch_weight;
+    stat->pending_sum = 0.0;
+    stat->pending_weight = 0.0;
+    if (stat->batch_count == OUTPUT_BATCH_LIMIT) {
+        merge_batches(stat);
+    }
+}
+
+/* Feed value with the given weight into the batches, closing each one as
+ * it fills; a time span may cover several batches */
+static void accumulate_batches(OutputStat* stat, double value, double weight) {
+    while (weight > 0.0) {
+        double room = stat->batch_weight - stat->pending_weight;
+        if (weight < room) {
+            stat->pending_sum += value * weight;
+            stat->pending_weight += weight;
+            return;
+        }
+        stat->pending_sum += value * room;
+        weight -= room;
+        close_batch(stat);
+    }
+}
+
+void output_stat_observe(OutputStat* stat, double value) {
+    if (stat == NULL) {
+        return;
+    }
+
+    stat->count++;
+    accumulate_moments(stat, value, 1.0);
+    accumulate_batches(stat, value, 1.0);
+}
+
+void output_stat_advance(OutputStat* stat, SimTime time) {
+    if (stat == NULL || stat->kind != OUTPUT_TIME_WEIGHTED || time <= stat->last_time) {
+        return;
+    }
+
+    double elapsed = sim_time_to_double(time - stat->last_time);
+    stat->last_time = time;
+    accumulate_moments(stat, stat->value, elapsed);
+    accumulate_batches(stat, stat->value, elapsed);
+}
+
+void output_stat_set(OutputStat* stat, SimTime time, double value) {
+    if (stat == NULL) {
+        return;
+    }
+
+    output_stat_advance(stat, time);
+    stat->value = value;
+    stat->count++;
+}
+
+uint64_t output_stat_count(const OutputStat* stat) {
+    return (stat != NULL) ? stat->count : 0;
+}
+
+double output_stat_mean(const OutputStat* stat) {
+    return (stat != NULL && stat->total_weight > 0.0) ? stat->mean : 0.0;
+}
+
+double output_stat_variance(const OutputStat* stat) {
+    if (stat == NULL || stat->total_weight <= 0.0) {
+        return 0.0;
+    }
+    /* Unbiased for observations; the time average for time-weighted outputs */
+    if (stat->kind == OUTPUT_OBSERVATION) {
+        return stat->total_weight > 1.0 ? stat->m2 / (stat->total_weight - 1.0) : 0.0;
+    }
+    return stat->m2 / stat->total_weight;
+}
+
+double output_stat_min(const OutputStat* stat) {
+    return (stat != NULL && stat->total_weight > 0.0) ? stat->min : 0.0;
+}
+
+double output_stat_max(const OutputStat* stat) {
+    return (stat != NULL && stat->total_weight > 0.0) ? stat->max : 0.0;
+}
+
+/* MSER: the number of leading batches d <= k/2 minimizing
+ * sum_{i>d} (Z_i - mean_{i>d} Z)^2 / (k - d)^2, from suffix sums in O(k) */
+static int mser_truncation(const OutputStat* stat) {
+    int k = stat->batch_count;
+    if (k < 2) {
+        return 0;
+    }
+
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    int best = 0;
+    double best_score = HUGE_VAL;
+    for (int d = k - 1; d >= 0; d--) {
+        double z = stat->batches[d];
+        sum += z;
+        sum_sq += z * z;
+        if (d > k / 2) {
+            continue;
+        }
+        double m = (double)(k - d);
+        double score = (sum_sq - sum * sum / m) / (m * m);
+        if (score <= best_score) {
+            best_score = score;
+            best = d;
+        }
+    }
+    return best;
+}
+
+double output_stat_warmup(const OutputStat* stat) {
+    if (stat == NULL) {
+        return 0.0;
+    }
+    return (double)mser_truncation(stat) * stat->batch_weight;
+}
+
+double output_stat_steady_mean(const OutputStat* stat) {
+    if (stat == NULL) {
+        return 0.0;
+    }
+    if (stat->batch_count == 0) {
+        return output_stat_mean(stat);
+    }
+
+    int start = mser_truncation(stat);
+    double sum = 0.0;
+    for (int i = start; i < stat->batch_count; i++) {
+        sum += stat->batches[i];
+    }
+    return sum / (double)(stat->batch_count - start);
+}
+
+ConfidenceInterval output_stat_ci(const OutputStat* stat, double confidence) {
+    ConfidenceInterval ci = {-HUGE_VAL, HUGE_VAL, confidence};
+    if (stat == NULL || confidence <= 0.0 || confidence >= 1.0) {
+        return ci;
+    }
+
+    int start = mser_truncation(stat);
+    int remaining = stat->batch_count - start;
+    int groups = remaining < OUTPUT_CI_BATCHES ? remaining : OUTPUT_CI_BATCHES;
+    if (groups < OUTPUT_CI_MIN_BATCHES) {
+        return ci;
+    }
+
+    /* Regroup into equal batches, dropping the leftovers nearest the warm-up */
+    int per_group = remaining / groups;
+    start = stat->batch_count - groups * per_group;
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    for (int g = 0; g < groups; g++) {
+        double group_sum = 0.0;
+        for (int i = 0; i < per_group; i++) {
+            group_sum += stat->batches[start + g * per_group + i];
+        }
+        double group_mean = group_sum / (double)per_group;
+        sum += group_mean;
+        sum_sq += group_mean * group_mean;
+    }
+
+    double mean = sum / (double)groups;
+    double variance = (sum_sq - sum * mean) / (double)(groups - 1);
+    if (variance < 0.0) {
+        variance = 0.0;
+    }
+    double t = stats_t_quantile(0.5 + confidence / 2.0, groups - 1);
+    double half_width = t * sqrt(variance / (double)groups);
+    ci.lower = mean - half_width;
+    ci.upper = mean + half_width;
+    return ci;
+}
+
+double output_stat_relative_half_width(const OutputStat* stat, double confidence) {
+    ConfidenceInterval ci = output_stat_ci(stat, confidence);
+    double mean = 0.5 * (ci.lower + ci.upper);
+    if (isinf(ci.lower) || isinf(ci.upper) || mean == 0.0) {
+        return HUGE_VAL;
+    }
+    return 0.5 * (ci.upper - ci.lower) / fabs(mean);
+}
+
+void output_stat_print(const OutputStat* stat) {
+    if (stat == NULL) {
+        return;
+    }
+
+    printf("  %s: mean %.6g, stddev %.6g, min %.6g, max %.6g\n",
+           stat->name, output_stat_mean(stat), sqrt(output_stat_variance(stat)),
+           output_stat_min(stat), output_stat_max(stat));
+
+    ConfidenceInterval ci = output_stat_ci(stat, 0.95);
+    if (isinf(ci.lower) || isinf(ci.upper)) {
+        printf("    steady state: mean %.6g after warm-up %.6g, too few batches for an interval\n",
+               output_stat_steady_mean(stat), output_stat_warmup(stat));
+    } else {
+        printf("    steady state: mean %.6g after warm-up %.6g, 95%% CI [%.6g, %.6g]\n",
+               output_stat_steady_mean(stat), output_stat_warmup(stat), ci.lower, ci.upper);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "time_simulation.h"
+#include "../math/statistics.h"
+
+/* Steady-state output analysis for SIMSCRIPT.
+ *
+ * An OutputStat collects one output online without storing samples:
+ * running moments over the whole run plus a bounded array of batch means.
+ * Batches start at 5 observations (or one interval of simulated time for a
+ * time-weighted output) and double in size whenever the array fills, so
+ * memory stays O(OUTPUT_BATCH_LIMIT) however long the run is. The warm-up
+ * period is the MSER-5 truncation point over the batch means, and
+ * confidence intervals use batch means after the warm-up. Once batches
+ * have merged, the warm-up is only resolved to whole batches. */
+
+#define OUTPUT_BATCH_LIMIT 256     /* Batch means kept before pairs merge */
+#define OUTPUT_MSER_BATCH 5        /* Observations per initial batch */
+#define OUTPUT_CI_BATCHES 30       /* Batches the post-warm-up data is regrouped into */
+#define OUTPUT_CI_MIN_BATCHES 10   /* Fewer than this and the interval is unbounded */
+
+typedef enum {
+    OUTPUT_OBSERVATION,        /* One value per observation, e.g. waiting times */
+    OUTPUT_TIME_WEIGHTED       /* Piecewise-constant value over time, e.g. queue length */
+} OutputKind;
+
+typedef struct OutputStat {
+    char* name;
+    OutputKind kind;
+
+    /* Weighted moments over the whole run; the weight is 1 per observation
+     * or the time a value was held */
+    uint64_t count;            /* Observations, or value changes */
+    double total_weight;
+    double mean;
+    double m2;
+    double min;
+    double max;
+
+    /* Time-weighted state */
+    double value;              /* Value held since last_time */
+    SimTime last_time;
+
+    /* Batch means */
+    double batches[OUTPUT_BATCH_LIMIT];
+    int batch_count;
+    double initial_batch_weight;
+    double batch_weight;       /* Weight of each completed batch */
+    double pending_sum;        /* Weighted sum of the batch being filled */
+    double pending_weight;
+} OutputStat;
+
+/* interval is the initial batch length in time units for time-weighted
+ * outputs and is ignored for observations */
+OutputStat* output_stat_create(const char* name, OutputKind kind, double interval);
+void output_stat_destroy(OutputStat* stat);
+
+/* Discard everything collected; a time-weighted output keeps its current
+ * value, held from time */
+void output_stat_reset(OutputStat* stat, SimTime time);
+
+/* Record an observation */
+void output_stat_observe(OutputStat* stat, double value);
+
+/* Time-weighted: the value changes to value at time; advance accounts for
+ * the current value up to time without changing it */
+void output_stat_set(OutputStat* stat, SimTime time, double value);
+void output_stat_advance(OutputStat* stat, SimTime time);
+
+/* Whole-run statistics, warm-up included */
+uint64_t output_stat_count(const OutputStat* stat);
+double output_stat_mean(const OutputStat* stat);
+double output_stat_variance(const OutputStat* stat);
+double output_stat_min(const OutputStat* stat);
+double output_stat_max(const OutputStat* stat);
+
+/* MSER-5 warm-up length, in observations or time units */
+double output_stat_warmup(const OutputStat* stat);
+
+/* Mean of the completed batches after the warm-up */
+double output_stat_steady_mean(const OutputStat* stat);
+
+/* Batch-means interval for the steady-state mean; unbounded until enough
+ * batches remain after the warm-up */
+ConfidenceInterval output_stat_ci(const OutputStat* stat, double confidence);
+
+/* CI half-width divided by |steady mean|; INFINITY while unbounded */
+double output_stat_relative_half_width(const OutputStat* stat, double confidence);
+
+/* Print the whole-run and steady-state statistics */
+void output_stat_print(const OutputStat* stat);
+
+#ifdef __cplusplus
+}
+#endif
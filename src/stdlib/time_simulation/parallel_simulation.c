@@ -0,0 +1,379 @@
+#include "parallel_simulation.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OUTBOX_INITIAL_CAPACITY 16
+#define PARALLEL_ORIGIN_SHIFT 40     /* Key = origin LP << 40 | origin counter */
+#define PARALLEL_MAX_PROCESSES (1 << 23)
+
+/* Reusable barrier (pthread_barrier_t is not available everywhere) */
+struct ParallelSync {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int waiting;
+    int parties;
+    uint64_t generation;
+};
+
+typedef struct WorkerArgs {
+    ParallelSimulator* psim;
+    int worker_id;
+} WorkerArgs;
+
+static _Thread_local LogicalProcess* current_process = NULL;
+
+static void sync_wait(struct ParallelSync* sync) {
+    pthread_mutex_lock(&sync->mutex);
+    uint64_t generation = sync->generation;
+    if (++sync->waiting == sync->parties) {
+        sync->waiting = 0;
+        sync->generation++;
+        pthread_cond_broadcast(&sync->cond);
+    } else {
+        while (generation == sync->generation) {
+            pthread_cond_wait(&sync->cond, &sync->mutex);
+        }
+    }
+    pthread_mutex_unlock(&sync->mutex);
+}
+
+/* Moves one LP's buffered messages into their target queues under the
+ * sender's keys. Returns false if any message was lost; the rest are still
+ * delivered. */
+static bool deliver_outbox(ParallelSimulator* psim, LogicalProcess* source) {
+    bool delivered = true;
+    for (int m = 0; m < source->outbox_count; m++) {
+        ParallelMessage* message = &source->outbox[m];
+        Simulator* target = psim->processes[message->target].sim;
+        Event* event = simulator_create_event_with_payload(target, message->time,
+                                                           message->type, message->payload,
+                                                           message->payload_size,
+                                                           message->handler);
+        free(message->payload);
+        if (event == NULL) {
+            delivered = false;
+            continue;
+        }
+
+        EventHandle handle = event_queue_schedule_with_key(target->event_queue, event,
+                                                           message->key);
+        if (!event_handle_is_valid(handle)) {
+            event_destroy(event);
+            delivered = false;
+            continue;
+        }
+        sim_stats_record_event(target->stats, event->type);
+    }
+    source->outbox_count = 0;
+    return delivered;
+}
+
+/* Runs on one thread between windows; a lost message fails the run */
+static void deliver_messages(ParallelSimulator* psim) {
+    for (int i = 0; i < psim->process_count; i++) {
+        if (!deliver_outbox(psim, &psim->processes[i])) {
+            psim->failed = true;
+        }
+    }
+}
+
+/* Computes the next safe window; returns false when the run is complete */
+static bool compute_window(ParallelSimulator* psim) {
+    SimTime earliest = psim->end_time;
+    SimTime window = psim->end_time;
+    bool pending = false;
+
+    for (int i = 0; i < psim->process_count; i++) {
+        LogicalProcess* lp = &psim->processes[i];
+        Event* next = event_queue_peek(lp->sim->event_queue);
+        if (next == NULL) {
+            continue;
+        }
+
+        pending = true;
+        if (next->time < earliest) {
+            earliest = next->time;
+        }
+        if (next->time + lp->lookahead < window) {
+            window = next->time + lp->lookahead;
+        }
+    }
+
+    psim->window_end = window;
+    return pending && earliest < psim->end_time;
+}
+
+static void process_window(ParallelSimulator* psim, LogicalProcess* lp) {
+    current_process = lp;
+    Simulator* sim = lp->sim;
+    Event* next;
+    while ((next = event_queue_peek(sim->event_queue)) != NULL &&
+           next->time < psim->window_end) {
+        simulator_step(sim);
+    }
+    current_process = NULL;
+}
+
+static void* worker_main(void* arg) {
+    WorkerArgs* args = (WorkerArgs*)arg;
+    ParallelSimulator* psim = args->psim;
+
+    while (1) {
+        if (args->worker_id == 0) {
+            deliver_messages(psim);
+            psim->finished = psim->failed || !compute_window(psim);
+            if (!psim->finished) {
+                psim->windows++;
+            }
+        }
+        sync_wait(psim->sync);
+
+        if (psim->finished) {
+            break;
+        }
+
+        /* Static round-robin partition of LPs over threads */
+        for (int i = args->worker_id; i < psim->process_count; i += psim->thread_count) {
+            process_window(psim, &psim->processes[i]);
+        }
+        sync_wait(psim->sync);
+    }
+
+    return NULL;
+}
+
+ParallelSimulator* parallel_simulator_create(int process_count, int thread_count,
+                                             SimTime start_time, SimTime end_time,
+                                             SimTime lookahead) {
+    if (process_count <= 0 || process_count > PARALLEL_MAX_PROCESSES ||
+        lookahead <= SIM_TIME_ZERO) {
+        return NULL;
+    }
+
+    ParallelSimulator* psim = (ParallelSimulator*)malloc(sizeof(ParallelSimulator));
+    if (psim == NULL) {
+        return NULL;
+    }
+
+    psim->processes = (LogicalProcess*)calloc((size_t)process_count, sizeof(LogicalProcess));
+    psim->sync = (struct ParallelSync*)malloc(sizeof(struct ParallelSync));
+    psim->process_count = process_count;
+    psim->thread_count = thread_count > 0 ? thread_count : 1;
+    if (psim->thread_count > process_count) {
+        psim->thread_count = process_count;
+    }
+    psim->end_time = end_time;
+    psim->window_end = start_time;
+    psim->finished = false;
+    psim->failed = false;
+    psim->windows = 0;
+
+    if (psim->processes == NULL || psim->sync == NULL) {
+        free(psim->sync);
+        psim->sync = NULL;
+        parallel_simulator_destroy(psim);
+        return NULL;
+    }
+
+    pthread_mutex_init(&psim->sync->mutex, NULL);
+    pthread_cond_init(&psim->sync->cond, NULL);
+    psim->sync->waiting = 0;
+    psim->sync->parties = psim->thread_count;
+    psim->sync->generation = 0;
+
+    for (int i = 0; i < process_count; i++) {
+        LogicalProcess* lp = &psim->processes[i];
+        lp->id = i;
+        lp->lookahead = lookahead;
+        lp->owner = psim;
+        lp->sim = simulator_create(start_time, end_time);
+        if (lp->sim == NULL) {
+            parallel_simulator_destroy(psim);
+            return NULL;
+        }
+        /* Local events and sent messages share the LP's key space */
+        lp->sim->event_queue->next_sequence = (uint64_t)i << PARALLEL_ORIGIN_SHIFT;
+    }
+
+    return psim;
+}
+
+void parallel_simulator_destroy(ParallelSimulator* psim) {
+    if (psim == NULL) {
+        return;
+    }
+
+    if (psim->processes != NULL) {
+        for (int i = 0; i < psim->process_count; i++) {
+            LogicalProcess* lp = &psim->processes[i];
+            for (int m = 0; m < lp->outbox_count; m++) {
+                free(lp->outbox[m].payload);
+            }
+            free(lp->outbox);
+            simulator_destroy(lp->sim);
+        }
+        free(psim->processes);
+    }
+
+    if (psim->sync != NULL) {
+        pthread_mutex_destroy(&psim->sync->mutex);
+        pthread_cond_destroy(&psim->sync->cond);
+        free(psim->sync);
+    }
+    free(psim);
+}
+
+LogicalProcess* parallel_simulator_get_process(ParallelSimulator* psim, int id) {
+    if (psim == NULL || id < 0 || id >= psim->process_count) {
+        return NULL;
+    }
+    return &psim->processes[id];
+}
+
+int parallel_simulator_run(ParallelSimulator* psim) {
+    if (psim == NULL) {
+        return -1;
+    }
+
+    for (int i = 0; i < psim->process_count; i++) {
+        if (psim->processes[i].lookahead <= SIM_TIME_ZERO) {
+            return -1;  /* Zero lookahead admits no safe window */
+        }
+    }
+
+    int helpers = psim->thread_count - 1;
+    pthread_t* threads = NULL;
+    WorkerArgs* args = (WorkerArgs*)malloc((size_t)psim->thread_count * sizeof(WorkerArgs));
+    if (helpers > 0) {
+        threads = (pthread_t*)malloc((size_t)helpers * sizeof(pthread_t));
+    }
+    if (args == NULL || (helpers > 0 && threads == NULL)) {
+        free(args);
+        free(threads);
+        return -1;
+    }
+
+    psim->finished = false;
+    psim->failed = false;
+    psim->sync->parties = psim->thread_count;
+    for (int i = 0; i < psim->thread_count; i++) {
+        args[i].psim = psim;
+        args[i].worker_id = i;
+    }
+
+    /* Run with fewer threads if the pool cannot be fully started */
+    int started = 0;
+    for (int i = 0; i < helpers; i++) {
+        if (pthread_create(&threads[i], NULL, worker_main, &args[i + 1]) != 0) {
+            break;
+        }
+        started++;
+    }
+    if (started < helpers) {
+        /* No barrier has completed yet, so the pool can still shrink */
+        pthread_mutex_lock(&psim->sync->mutex);
+        psim->thread_count = started + 1;
+        psim->sync->parties = started + 1;
+        pthread_mutex_unlock(&psim->sync->mutex);
+        helpers = started;
+    }
+
+    worker_main(&args[0]);
+
+    for (int i = 0; i < helpers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(args);
+    free(threads);
+    return psim->failed ? -1 : 0;
+}
+
+int parallel_simulator_run_sequential(ParallelSimulator* psim) {
+    if (psim == NULL) {
+        return -1;
+    }
+
+    psim->failed = false;
+    deliver_messages(psim);  /* Messages sent before the run */
+
+    while (!psim->failed) {
+        LogicalProcess* lp = NULL;
+        Event* earliest = NULL;
+        for (int i = 0; i < psim->process_count; i++) {
+            Event* next = event_queue_peek(psim->processes[i].sim->event_queue);
+            if (next != NULL &&
+                (earliest == NULL || next->time < earliest->time ||
+                 (next->time == earliest->time && next->sequence < earliest->sequence))) {
+                earliest = next;
+                lp = &psim->processes[i];
+            }
+        }
+        if (earliest == NULL || earliest->time >= psim->end_time) {
+            break;
+        }
+
+        current_process = lp;
+        simulator_step(lp->sim);
+        current_process = NULL;
+        if (!deliver_outbox(psim, lp)) {
+            psim->failed = true;
+        }
+    }
+
+    return psim->failed ? -1 : 0;
+}
+
+void logical_process_set_lookahead(LogicalProcess* lp, SimTime lookahead) {
+    if (lp != NULL) {
+        lp->lookahead = lookahead;
+    }
+}
+
+LogicalProcess* logical_process_current(void) {
+    return current_process;
+}
+
+bool logical_process_send(LogicalProcess* from, int target, SimTime time, EventType type,
+                          const void* payload, size_t size, void (*handler)(Event*)) {
+    if (from == NULL || from->owner == NULL || target < 0 ||
+        target >= from->owner->process_count) {
+        return false;
+    }
+
+    if (time < sim_clock_get_time(from->sim->clock) + from->lookahead) {
+        return false;  /* Would break the lookahead promise */
+    }
+
+    if (from->outbox_count == from->outbox_capacity) {
+        int new_capacity = from->outbox_capacity > 0 ? from->outbox_capacity * 2
+                                                     : OUTBOX_INITIAL_CAPACITY;
+        ParallelMessage* outbox = (ParallelMessage*)realloc(
+            from->outbox, (size_t)new_capacity * sizeof(ParallelMessage));
+        if (outbox == NULL) {
+            return false;
+        }
+        from->outbox = outbox;
+        from->outbox_capacity = new_capacity;
+    }
+
+    void* copy = NULL;
+    if (payload != NULL && size > 0) {
+        copy = malloc(size);
+        if (copy == NULL) {
+            return false;
+        }
+        memcpy(copy, payload, size);
+    }
+
+    ParallelMessage* message = &from->outbox[from->outbox_count++];
+    message->key = from->sim->event_queue->next_sequence++;
+    message->target = target;
+    message->time = time;
+    message->type = type;
+    message->handler = handler;
+    message->payload = copy;
+    message->payload_size = copy != NULL ? size : 0;
+    return true;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "time_simulation.h"
+
+/* Conservative parallel discrete-event simulation for SIMSCRIPT.
+ *
+ * The model is partitioned into logical processes (LPs), each with its own
+ * Simulator. Execution proceeds in synchronous windows (YAWNS): every LP may
+ * process its events earlier than min over all LPs of (next event time +
+ * lookahead), since no message sent in the window can arrive before that.
+ * Messages between LPs are buffered and delivered at window boundaries.
+ *
+ * Every event carries a tie-break key (origin LP << 40 | origin counter):
+ * each LP numbers the events it schedules locally and the messages it
+ * sends from one counter, and equal times are ordered by that key rather
+ * than by arrival. An LP therefore sees the same event sequence however
+ * the windows fall, and parallel_simulator_run_sequential, which executes
+ * the same partitioned model one event at a time in global (time, key)
+ * order, gives bit-identical results for any thread count. A single
+ * Simulator running the unpartitioned model orders ties by insertion
+ * order instead and is not a reference for equal-time events. */
+
+/* Message buffered between logical processes */
+typedef struct ParallelMessage {
+    int target;
+    SimTime time;
+    EventType type;
+    void (*handler)(Event*);
+    uint64_t key;              /* Tie-break key taken from the sender's counter */
+    void* payload;             /* Private copy, freed after delivery */
+    size_t payload_size;
+} ParallelMessage;
+
+struct ParallelSimulator;
+struct ParallelSync;
+
+/* Logical process */
+typedef struct LogicalProcess {
+    int id;
+    Simulator* sim;            /* Own event queue, clock and statistics */
+    SimTime lookahead;         /* Minimum delay on messages sent to other LPs */
+    void* state;               /* User state */
+    struct ParallelSimulator* owner;
+    ParallelMessage* outbox;
+    int outbox_count;
+    int outbox_capacity;
+} LogicalProcess;
+
+/* Parallel simulator: logical processes run by a fixed pool of threads */
+typedef struct ParallelSimulator {
+    LogicalProcess* processes;
+    int process_count;
+    int thread_count;
+    SimTime end_time;
+    SimTime window_end;        /* Events before this time are safe to process */
+    bool finished;
+    bool failed;               /* A message could not be delivered */
+    uint64_t windows;          /* Synchronization rounds executed */
+    struct ParallelSync* sync; /* Thread pool barrier state */
+} ParallelSimulator;
+
+/* Create a parallel simulator with process_count LPs, each starting with
+ * the given lookahead (must be positive) */
+ParallelSimulator* parallel_simulator_create(int process_count, int thread_count,
+                                             SimTime start_time, SimTime end_time,
+                                             SimTime lookahead);
+
+/* Destroy the simulator and every logical process */
+void parallel_simulator_destroy(ParallelSimulator* psim);
+
+/* Get logical process by id */
+LogicalProcess* parallel_simulator_get_process(ParallelSimulator* psim, int id);
+
+/* Run until no events earlier than end_time remain (returns 0 on success,
+ * -1 if a message could not be delivered) */
+int parallel_simulator_run(ParallelSimulator* psim);
+
+/* Run the same model on the calling thread, one event at a time in global
+ * (time, key) order with messages delivered as they are sent; a reference
+ * for checking parallel_simulator_run (same return values) */
+int parallel_simulator_run_sequential(ParallelSimulator* psim);
+
+/* Set the lookahead of one logical process */
+void logical_process_set_lookahead(LogicalProcess* lp, SimTime lookahead);
+
+/* Logical process whose handler is running on this thread */
+LogicalProcess* logical_process_current(void);
+
+/* Send an event to another LP; time must be at least now + lookahead.
+ * The payload is copied. Returns false if the message is rejected. */
+bool logical_process_send(LogicalProcess* from, int target, SimTime time, EventType type,
+                          const void* payload, size_t size, void (*handler)(Event*));
+
+#ifdef __cplusplus
+}
+#endif
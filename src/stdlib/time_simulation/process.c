@@ -0,0 +1,237 @@
+#include "process.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void process_resume(Event* event);
+
+static void process_link(Process* process) {
+    Simulator* sim = process->sim;
+    process->prev = NULL;
+    process->next = sim->processes;
+    if (sim->processes != NULL) {
+        sim->processes->prev = process;
+    }
+    sim->processes = process;
+}
+
+static void process_unlink(Process* process) {
+    if (process->prev != NULL) {
+        process->prev->next = process->next;
+    } else {
+        process->sim->processes = process->next;
+    }
+    if (process->next != NULL) {
+        process->next->prev = process->prev;
+    }
+}
+
+Process* process_create(Simulator* sim, ProcessBody body, size_t locals_size) {
+    if (sim == NULL || body == NULL) {
+        return NULL;
+    }
+
+    Process* process = (Process*)malloc(sizeof(Process) + locals_size);
+    if (process == NULL) {
+        return NULL;
+    }
+    memset(process, 0, sizeof(Process) + locals_size);
+
+    process->wake_event = simulator_create_event(sim, SIM_TIME_ZERO, EVENT_CUSTOM,
+                                                 process, process_resume);
+    if (process->wake_event == NULL) {
+        free(process);
+        return NULL;
+    }
+    event_retain(process->wake_event);
+
+    process->body = body;
+    process->resume_point = 0;
+    process->state = PROCESS_CREATED;
+    process->sim = sim;
+    process->wake_handle.index = EVENT_HANDLE_INVALID_INDEX;
+    process->remaining = SIM_TIME_ZERO;
+    process->waiter.index = -1;
+    process_link(process);
+    return process;
+}
+
+static bool process_schedule(Process* process, SimTime time) {
+    if (process->wake_event == NULL) {
+        return false;
+    }
+    process->wake_event->time = time;
+    process->wake_handle = simulator_schedule_event(process->sim, process->wake_event);
+    if (!event_handle_is_valid(process->wake_handle)) {
+        return false;
+    }
+    process->state = PROCESS_SCHEDULED;
+    return true;
+}
+
+bool process_activate(Process* process, SimTime time) {
+    if (process == NULL ||
+        (process->state != PROCESS_CREATED && process->state != PROCESS_PASSIVE)) {
+        return false;
+    }
+
+    /* Preempted while passive: resume once the units are back */
+    if (!process->waiter.holding && process->waiter.index >= 0) {
+        SimTime now = process->sim->clock->current_time;
+        process->remaining = time > now ? time - now : SIM_TIME_ZERO;
+        process->state = PROCESS_REQUESTING;
+        return true;
+    }
+    return process_schedule(process, time);
+}
+
+Process* process_start(Simulator* sim, ProcessBody body, size_t locals_size) {
+    Process* process = process_create(sim, body, locals_size);
+    if (process != NULL && !process_activate(process, sim->clock->current_time)) {
+        process_destroy(process);
+        return NULL;
+    }
+    return process;
+}
+
+/* Frees the process; its wake event goes back to whoever owns it now */
+static void process_free(Process* process) {
+    if (process->waiter.holding) {
+        resource_untrack_holder(process->waiter.resource, &process->waiter);
+    }
+
+    switch (process->state) {
+        case PROCESS_SCHEDULED:
+            /* The queue frees the cancelled event */
+            simulator_cancel_event(process->sim, process->wake_handle);
+            break;
+        case PROCESS_RUNNING:
+        case PROCESS_TERMINATED:
+            /* Being dispatched: the dispatcher frees it after the handler */
+            process->wake_event->retained = false;
+            break;
+        case PROCESS_REQUESTING:
+        case PROCESS_PASSIVE:
+            /* No-op unless queued for units */
+            resource_cancel_wait(process->waiter.resource, &process->waiter);
+            event_destroy(process->wake_event);
+            break;
+        default:
+            event_destroy(process->wake_event);
+            break;
+    }
+
+    process_unlink(process);
+    free(process);
+}
+
+void process_destroy(Process* process) {
+    if (process == NULL || process->state == PROCESS_RUNNING) {
+        return;  /* A running process ends by reaching PROCESS_END */
+    }
+    process_free(process);
+}
+
+void process_destroy_all(Simulator* sim) {
+    while (sim->processes != NULL) {
+        process_free(sim->processes);
+    }
+}
+
+ProcessState process_get_state(const Process* process) {
+    return (process != NULL) ? process->state : PROCESS_TERMINATED;
+}
+
+static void process_resume(Event* event) {
+    Process* process = (Process*)event->data;
+    process->state = PROCESS_RUNNING;
+    process->body(process);
+
+    /* Returning without suspending ends the process too */
+    if (process->state == PROCESS_RUNNING || process->state == PROCESS_TERMINATED) {
+        process->state = PROCESS_TERMINATED;
+        process_free(process);
+    }
+}
+
+void process_hold(Process* process, SimTime delay) {
+    if (delay < SIM_TIME_ZERO) {
+        delay = SIM_TIME_ZERO;
+    }
+    process_schedule(process, process->sim->clock->current_time + delay);
+}
+
+static Process* waiter_process(ResourceWaiter* waiter) {
+    return (Process*)((char*)waiter - offsetof(Process, waiter));
+}
+
+/* Grant callback: resume at the release time, after the releasing event,
+ * plus whatever hold time a preemption interrupted. A passive process just
+ * gets its units back. */
+static void process_granted(ResourceWaiter* waiter) {
+    Process* process = waiter_process(waiter);
+    if (process->state != PROCESS_REQUESTING) {
+        return;
+    }
+    SimTime remaining = process->remaining;
+    process->remaining = SIM_TIME_ZERO;
+    process_schedule(process, process->sim->clock->current_time + remaining);
+}
+
+/* Preempt callback: stop the current hold and wait for the units again; a
+ * passive process stays passive while it waits */
+static void process_preempted(ResourceWaiter* waiter) {
+    Process* process = waiter_process(waiter);
+    if (process->state == PROCESS_PASSIVE) {
+        return;
+    }
+    if (process->state == PROCESS_SCHEDULED) {
+        SimTime now = process->sim->clock->current_time;
+        SimTime wake = process->wake_event->time;
+        process->remaining = wake > now ? wake - now : SIM_TIME_ZERO;
+
+        /* The queue frees a cancelled event, so the process needs a new one */
+        simulator_cancel_event(process->sim, process->wake_handle);
+        process->wake_event = simulator_create_event(process->sim, SIM_TIME_ZERO, EVENT_CUSTOM,
+                                                     process, process_resume);
+        if (process->wake_event != NULL) {
+            event_retain(process->wake_event);
+        }
+    }
+    process->state = PROCESS_REQUESTING;
+}
+
+bool process_request(Process* process, Resource* resource, int units, int priority) {
+    if (resource == NULL || units <= 0 || units > resource->total_units) {
+        return true;  /* Cannot ever be granted; continue without units */
+    }
+
+    /* The embedded waiter moves on to this request */
+    if (process->waiter.holding) {
+        resource_untrack_holder(process->waiter.resource, &process->waiter);
+    }
+
+    process->waiter.priority = priority;
+    process->waiter.grant = process_granted;
+    process->waiter.preempt = process_preempted;
+    if (resource_request_or_wait(resource, &process->waiter, units) != RESOURCE_QUEUED) {
+        return true;  /* Granted, or rejected for lack of memory */
+    }
+
+    process->state = PROCESS_REQUESTING;
+    return false;
+}
+
+void process_relinquish(Process* process, Resource* resource, int units) {
+    if (process != NULL && process->waiter.holding && process->waiter.resource == resource) {
+        resource_untrack_holder(resource, &process->waiter);
+    }
+    resource_release(resource, units);
+}
+
+void process_passivate(Process* process) {
+    process->state = PROCESS_PASSIVE;
+}
+
+void process_finish(Process* process) {
+    process->state = PROCESS_TERMINATED;
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include "time_simulation.h"
+#include "../data_structures/resource.h"
+
+/* Process-interaction layer for SIMSCRIPT.
+ *
+ * A process is a stackless coroutine: its body is an ordinary function
+ * that the scheduler calls again on every resumption, and PROCESS_BEGIN
+ * jumps back to the statement after the last suspension. Locals of the
+ * body do not survive a suspension; keep state in the process's locals
+ * block (PROCESS_LOCALS). Each process owns one retained event that is
+ * rescheduled for every resumption and a waiter embedded for REQUEST, so
+ * suspending and resuming allocate nothing. The suspension macros expand
+ * to case labels, so they cannot be used inside a switch in the body.
+ *
+ *     static void customer(Process* p) {
+ *         PROCESS_BEGIN(p);
+ *         REQUEST(p, clerk, 1);
+ *         WORK(p, sim_time_from_double(2.5));
+ *         RELINQUISH(p, clerk, 1);
+ *         PROCESS_END(p);
+ *     }
+ *
+ * A process preempted on a PREEMPTIVE resource during WAIT/WORK stops, is
+ * queued again ahead of its priority class, and finishes the remaining
+ * time once it gets the units back. Only the resource of the last REQUEST
+ * can preempt a process. A passive (SUSPENDed) process that is preempted
+ * stays passive and gets its units back without resuming; activating it
+ * before then makes it resume once it has them.
+ *
+ * A REQUEST that can never be granted (a NULL resource, no units or more
+ * than the resource's total_units) does not block: the process continues
+ * at once without units, so check the request against the resource when
+ * that can happen. The same holds when the resource has no memory left
+ * to queue the process; waiter.resource is then NULL.
+ *
+ * A process is freed when its body reaches PROCESS_END; processes still
+ * alive when their simulator is destroyed are freed with it. A simulator
+ * with live processes cannot be checkpointed (checkpoint.h), so trace
+ * checkpoints are not taken while any exist. */
+
+typedef struct Process Process;
+typedef void (*ProcessBody)(Process* process);
+
+typedef enum {
+    PROCESS_CREATED,           /* Not activated yet */
+    PROCESS_SCHEDULED,         /* Wake event in the queue */
+    PROCESS_RUNNING,
+    PROCESS_REQUESTING,        /* Blocked in REQUEST */
+    PROCESS_PASSIVE,           /* Suspended until process_activate */
+    PROCESS_TERMINATED
+} ProcessState;
+
+struct Process {
+    ProcessBody body;
+    int resume_point;          /* Line of the last suspension, 0 to start */
+    ProcessState state;
+    Simulator* sim;
+    Event* wake_event;         /* Retained; rescheduled for every resumption */
+    EventHandle wake_handle;
+    ResourceWaiter waiter;     /* Queued on a resource while requesting */
+    SimTime remaining;         /* Hold time left when preempted */
+    Process* prev;             /* Simulator's list of live processes */
+    Process* next;
+    _Alignas(max_align_t) unsigned char locals[];
+};
+
+#define PROCESS_LOCALS(process, type) ((type*)(void*)(process)->locals)
+
+#define PROCESS_BEGIN(process) switch ((process)->resume_point) { case 0:
+
+#define PROCESS_END(process) } process_finish(process); return
+
+/* Resume after delay of simulated time */
+#define WAIT(process, delay)                        \
+    do {                                            \
+        (process)->resume_point = __LINE__;         \
+        process_hold((process), (delay));           \
+        return;                                     \
+        case __LINE__:;                             \
+    } while (0)
+
+/* SIMSCRIPT WORK: time spent in service, scheduled like WAIT */
+#define WORK(process, delay) WAIT(process, delay)
+
+/* Continue once units of resource are allocated to the process; higher
+ * priorities are served first on PRIORITY and PREEMPTIVE resources */
+#define REQUEST_PRIORITY(process, resource, units, priority)                     \
+    do {                                                                         \
+        (process)->resume_point = __LINE__;                                      \
+        if (!process_request((process), (resource), (units), (priority))) {      \
+            return;                                                              \
+        }                                                                        \
+        case __LINE__:;                                                          \
+    } while (0)
+
+#define REQUEST(process, resource, units) REQUEST_PRIORITY(process, resource, units, 0)
+
+/* Give units back; use this rather than resource_release on preemptive
+ * resources so the process stops being a preemption candidate */
+#define RELINQUISH(process, resource, units) process_relinquish((process), (resource), (units))
+
+/* Suspend until another process or event calls process_activate */
+#define SUSPEND(process)                            \
+    do {                                            \
+        (process)->resume_point = __LINE__;         \
+        process_passivate(process);                 \
+        return;                                     \
+        case __LINE__:;                             \
+    } while (0)
+
+/* Create a process with locals_size bytes of zeroed locals; it does not run
+ * until activated */
+Process* process_create(Simulator* sim, ProcessBody body, size_t locals_size);
+
+/* Schedule a created or passive process to run at time; a passive one
+ * still waiting for preempted units runs as much later than the grant */
+bool process_activate(Process* process, SimTime time);
+
+/* Create and activate at the current time */
+Process* process_start(Simulator* sim, ProcessBody body, size_t locals_size);
+
+/* Stop and free a process that is not running (e.g. to interrupt it) */
+void process_destroy(Process* process);
+
+/* Free every process of sim; simulator_destroy calls this */
+void process_destroy_all(Simulator* sim);
+
+ProcessState process_get_state(const Process* process);
+
+/* Used by the macros */
+void process_hold(Process* process, SimTime delay);
+bool process_request(Process* process, Resource* resource, int units, int priority);
+void process_relinquish(Process* process, Resource* resource, int units);
+void process_passivate(Process* process);
+void process_finish(Process* process);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,169 @@
+#include "replication.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+typedef struct ReplicationPool {
+    ReplicationResults* results;
+    ReplicationModel model;
+    void* user;
+    uint64_t seed_base;
+    SimTime start_time;
+    SimTime end_time;
+    atomic_int next;           /* Next replication index to hand out */
+    atomic_int failed;
+    atomic_uint_fast64_t total_events;
+} ReplicationPool;
+
+static _Thread_local Replication* current_replication = NULL;
+
+static void run_one(ReplicationPool* pool, int index) {
+    Replication rep;
+    rep.index = index;
+    rep.seed = pool->seed_base;
+    rep.user = pool->user;
+    rep.sim = simulator_create(pool->start_time, pool->end_time);
+    if (rep.sim == NULL) {
+        pool->results->values[index] = NAN;
+        atomic_fetch_add(&pool->failed, 1);
+        return;
+    }
+    random_init_stream(&rep.rng, rep.seed, (uint64_t)index);
+
+    Random* previous = random_set_global(&rep.rng);
+    simulator_set_current(rep.sim);
+    current_replication = &rep;
+    pool->results->values[index] = pool->model(&rep);
+    current_replication = NULL;
+    simulator_set_current(NULL);
+    random_set_global(previous);
+
+    atomic_fetch_add(&pool->total_events, (uint_fast64_t)rep.sim->stats->total_events);
+    simulator_destroy(rep.sim);
+}
+
+static void* worker_main(void* arg) {
+    ReplicationPool* pool = (ReplicationPool*)arg;
+    int index;
+    while ((index = atomic_fetch_add(&pool->next, 1)) < pool->results->count) {
+        run_one(pool, index);
+    }
+    return NULL;
+}
+
+ReplicationResults* replication_run(int replications, int thread_count, uint64_t seed_base,
+                                    SimTime start_time, SimTime end_time,
+                                    ReplicationModel model, void* user) {
+    if (replications <= 0 || model == NULL) {
+        return NULL;
+    }
+
+    ReplicationResults* results = (ReplicationResults*)malloc(sizeof(ReplicationResults));
+    if (results == NULL) {
+        return NULL;
+    }
+    results->values = (double*)malloc((size_t)replications * sizeof(double));
+    if (results->values == NULL) {
+        free(results);
+        return NULL;
+    }
+    results->count = replications;
+
+    ReplicationPool pool;
+    pool.results = results;
+    pool.model = model;
+    pool.user = user;
+    pool.seed_base = seed_base;
+    pool.start_time = start_time;
+    pool.end_time = end_time;
+    atomic_init(&pool.next, 0);
+    atomic_init(&pool.failed, 0);
+    atomic_init(&pool.total_events, 0);
+
+    int helpers = thread_count > 0 ? thread_count - 1 : 0;
+    if (helpers > replications - 1) {
+        helpers = replications - 1;
+    }
+    pthread_t* threads = NULL;
+    if (helpers > 0) {
+        threads = (pthread_t*)malloc((size_t)helpers * sizeof(pthread_t));
+        if (threads == NULL) {
+            helpers = 0;
+        }
+    }
+
+    /* Run with fewer threads if the pool cannot be fully started */
+    int started = 0;
+    for (int i = 0; i < helpers; i++) {
+        if (pthread_create(&threads[i], NULL, worker_main, &pool) != 0) {
+            break;
+        }
+        started++;
+    }
+
+    worker_main(&pool);
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+
+    results->failed = atomic_load(&pool.failed);
+    results->total_events = (uint64_t)atomic_load(&pool.total_events);
+
+    /* Aggregate over successful replications, in index order */
+    double sum = 0.0;
+    int n = 0;
+    for (int i = 0; i < replications; i++) {
+        if (!isnan(results->values[i])) {
+            sum += results->values[i];
+            n++;
+        }
+    }
+    results->mean = n > 0 ? sum / n : 0.0;
+
+    double sum_sq = 0.0;
+    for (int i = 0; i < replications; i++) {
+        if (!isnan(results->values[i])) {
+            double diff = results->values[i] - results->mean;
+            sum_sq += diff * diff;
+        }
+    }
+    results->stddev = n > 1 ? sqrt(sum_sq / (n - 1)) : 0.0;
+
+    return results;
+}
+
+void replication_results_destroy(ReplicationResults* results) {
+    if (results != NULL) {
+        free(results->values);
+        free(results);
+    }
+}
+
+ConfidenceInterval replication_results_ci(ReplicationResults* results, double confidence) {
+    ConfidenceInterval ci = {0.0, 0.0, confidence};
+    if (results == NULL) {
+        return ci;
+    }
+
+    /* Leave out failed replications and NaN responses, as the mean does */
+    double* values = (double*)malloc((size_t)results->count * sizeof(double));
+    if (values == NULL) {
+        return ci;
+    }
+    int n = 0;
+    for (int i = 0; i < results->count; i++) {
+        if (!isnan(results->values[i])) {
+            values[n++] = results->values[i];
+        }
+    }
+    ci = stats_mean_ci(values, n, confidence);
+    free(values);
+    return ci;
+}
+
+Replication* replication_current(void) {
+    return current_replication;
+}
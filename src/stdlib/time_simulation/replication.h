@@ -0,0 +1,60 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "time_simulation.h"
+#include "../math/random.h"
+#include "../math/statistics.h"
+
+/* Independent replications for SIMSCRIPT.
+ *
+ * Runs the same model with independent random streams on a pool of
+ * threads. Each replication gets its own Simulator (clock, event queue,
+ * pool, SimStats) and its own Random, stream index of seed_base
+ * (random_init_stream), installed as the thread's global generator while
+ * the model runs, so models written against the global API need no
+ * changes. Results are stored by index and do not depend on the thread
+ * count. */
+
+/* One replication, passed to the model */
+typedef struct Replication {
+    int index;
+    uint64_t seed;             /* seed_base; rng is stream index of it */
+    Simulator* sim;
+    Random rng;
+    void* user;
+} Replication;
+
+/* Runs one replication and returns its response value */
+typedef double (*ReplicationModel)(Replication* rep);
+
+/* Responses of all replications */
+typedef struct ReplicationResults {
+    double* values;            /* Response of replication i at index i */
+    int count;
+    int failed;                /* Replications whose Simulator could not be created */
+    uint64_t total_events;     /* Events scheduled over all replications */
+    double mean;
+    double stddev;
+} ReplicationResults;
+
+/* Run replications on up to thread_count threads */
+ReplicationResults* replication_run(int replications, int thread_count, uint64_t seed_base,
+                                    SimTime start_time, SimTime end_time,
+                                    ReplicationModel model, void* user);
+
+/* Free results */
+void replication_results_destroy(ReplicationResults* results);
+
+/* Confidence interval for the mean response; like mean and stddev it
+ * leaves out failed replications and NaN responses */
+ConfidenceInterval replication_results_ci(ReplicationResults* results, double confidence);
+
+/* Replication running on this thread, NULL outside a model */
+Replication* replication_current(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,177 @@
+#include "sim_counters.h"
+#include "output_analysis.h"
+#include <math.h>
+
+static const char* counter_type_names[SIM_COUNTER_EVENT_TYPES] = {
+    "arrival", "departure", "timeout", "custom"
+};
+
+SimCounters* simulator_get_counters(Simulator* sim) {
+    return (sim != NULL) ? sim->counters : NULL;
+}
+
+static double queue_average_steps(EventQueue* queue) {
+#ifdef SIM_INSTRUMENT
+    if (queue->schedule_calls > 0) {
+        return (double)queue->schedule_steps / (double)queue->schedule_calls;
+    }
+#else
+    (void)queue;
+#endif
+    return 0.0;
+}
+
+static uint64_t counters_total(const uint64_t* counts, int n) {
+    uint64_t total = 0;
+    for (int i = 0; i < n; i++) {
+        total += counts[i];
+    }
+    return total;
+}
+
+static void print_histogram(const char* title, const uint64_t* buckets) {
+    printf("  %s:\n", title);
+    for (int i = 0; i < SIM_COUNTER_BUCKETS; i++) {
+        if (buckets[i] > 0) {
+            unsigned long long low = (1ULL << i) - 1;
+            if (i == SIM_COUNTER_BUCKETS - 1) {
+                printf("    [%llu, ...): %llu\n", low, (unsigned long long)buckets[i]);
+            } else {
+                printf("    [%llu, %llu]: %llu\n", low, (1ULL << (i + 1)) - 2,
+                       (unsigned long long)buckets[i]);
+            }
+        }
+    }
+}
+
+void simulator_print_report(Simulator* sim) {
+    if (sim == NULL) {
+        return;
+    }
+
+    sim_stats_print(sim->stats);
+
+    SimCounters* counters = sim->counters;
+    if (counters == NULL) {
+        return;
+    }
+
+    printf("Kernel Counters:\n");
+    printf("  %-10s %12s %12s %12s\n", "Type", "Scheduled", "Dispatched", "Cancelled");
+    for (int i = 0; i < SIM_COUNTER_EVENT_TYPES; i++) {
+        printf("  %-10s %12llu %12llu %12llu\n", counter_type_names[i],
+               (unsigned long long)counters->scheduled[i],
+               (unsigned long long)counters->dispatched[i],
+               (unsigned long long)counters->cancelled[i]);
+    }
+    printf("  Average Schedule Steps: %.3f\n", queue_average_steps(sim->event_queue));
+
+    uint64_t handled = counters_total(counters->handler_time, SIM_COUNTER_BUCKETS);
+    printf("  Average Handler Ticks: %.1f\n",
+           handled > 0 ? (double)counters->handler_time_total / (double)handled : 0.0);
+    print_histogram("Queue Depth", counters->queue_depth);
+    print_histogram("Handler Ticks", counters->handler_time);
+}
+
+static void json_string(FILE* out, const char* text) {
+    fputc('"', out);
+    for (const char* c = text; c != NULL && *c != '\0'; c++) {
+        unsigned char ch = (unsigned char)*c;
+        if (ch == '"' || ch == '\\') {
+            fprintf(out, "\\%c", ch);
+        } else if (ch < 0x20) {
+            fprintf(out, "\\u%04x", ch);
+        } else {
+            fputc(ch, out);
+        }
+    }
+    fputc('"', out);
+}
+
+/* JSON has no infinities or NaN */
+static void json_number(FILE* out, double value) {
+    if (isfinite(value)) {
+        fprintf(out, "%.17g", value);
+    } else {
+        fputs("null", out);
+    }
+}
+
+static void json_counts(FILE* out, const uint64_t* counts, int n) {
+    fputc('[', out);
+    for (int i = 0; i < n; i++) {
+        fprintf(out, "%s%llu", i > 0 ? ", " : "", (unsigned long long)counts[i]);
+    }
+    fputc(']', out);
+}
+
+static void json_outputs(FILE* out, SimStats* stats) {
+    fputs("  \"outputs\": [", out);
+    for (int i = 0; i < stats->output_count; i++) {
+        OutputStat* stat = stats->outputs[i];
+        ConfidenceInterval ci = output_stat_ci(stat, 0.95);
+        fputs(i > 0 ? ",\n    {\"name\": " : "\n    {\"name\": ", out);
+        json_string(out, stat->name);
+        fprintf(out, ", \"count\": %llu, \"mean\": ", (unsigned long long)output_stat_count(stat));
+        json_number(out, output_stat_mean(stat));
+        fputs(", \"variance\": ", out);
+        json_number(out, output_stat_variance(stat));
+        fputs(", \"min\": ", out);
+        json_number(out, output_stat_min(stat));
+        fputs(", \"max\": ", out);
+        json_number(out, output_stat_max(stat));
+        fputs(", \"steady_mean\": ", out);
+        json_number(out, output_stat_steady_mean(stat));
+        fputs(", \"ci95\": [", out);
+        json_number(out, ci.lower);
+        fputs(", ", out);
+        json_number(out, ci.upper);
+        fputs("]}", out);
+    }
+    fputs(stats->output_count > 0 ? "\n  ]" : "]", out);
+}
+
+static void json_counters(FILE* out, Simulator* sim) {
+    SimCounters* counters = sim->counters;
+
+    fputs(",\n  \"counters\": {\n    \"event_types\": [", out);
+    for (int i = 0; i < SIM_COUNTER_EVENT_TYPES; i++) {
+        fprintf(out, "%s\"%s\"", i > 0 ? ", " : "", counter_type_names[i]);
+    }
+    fputs("],\n    \"scheduled\": ", out);
+    json_counts(out, counters->scheduled, SIM_COUNTER_EVENT_TYPES);
+    fputs(",\n    \"dispatched\": ", out);
+    json_counts(out, counters->dispatched, SIM_COUNTER_EVENT_TYPES);
+    fputs(",\n    \"cancelled\": ", out);
+    json_counts(out, counters->cancelled, SIM_COUNTER_EVENT_TYPES);
+    fputs(",\n    \"average_schedule_steps\": ", out);
+    json_number(out, queue_average_steps(sim->event_queue));
+    fputs(",\n    \"queue_depth_log2\": ", out);
+    json_counts(out, counters->queue_depth, SIM_COUNTER_BUCKETS);
+    fputs(",\n    \"handler_ticks_log2\": ", out);
+    json_counts(out, counters->handler_time, SIM_COUNTER_BUCKETS);
+    fprintf(out, ",\n    \"handler_ticks_total\": %llu\n  }",
+            (unsigned long long)counters->handler_time_total);
+}
+
+bool simulator_write_report_json(Simulator* sim, FILE* out) {
+    if (sim == NULL || out == NULL) {
+        return false;
+    }
+
+    SimStats* stats = sim->stats;
+    fprintf(out, "{\n  \"total_events\": %d,\n  \"processed_events\": %d,\n",
+            stats->total_events, stats->processed_events);
+    fprintf(out, "  \"dispatched\": %llu,\n  \"total_time\": ",
+            (unsigned long long)sim->dispatched);
+    json_number(out, sim_time_to_double(stats->total_time));
+    fputs(",\n  \"idle_time\": ", out);
+    json_number(out, sim_time_to_double(stats->idle_time));
+    fprintf(out, ",\n  \"pool_high_water\": %zu,\n", event_pool_high_water(sim->event_pool));
+    json_outputs(out, stats);
+    if (sim->counters != NULL) {
+        json_counters(out, sim);
+    }
+    fputs("\n}\n", out);
+    return !ferror(out);
+}
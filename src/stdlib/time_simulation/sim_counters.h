@@ -0,0 +1,79 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include "time_simulation.h"
+
+/* Kernel instrumentation for SIMSCRIPT.
+ *
+ * Built only with SIM_INSTRUMENT (CMake option SIMSCRIPT_INSTRUMENT);
+ * otherwise every SIM_COUNT statement compiles away, simulators carry no
+ * counters and the report functions only print the basic statistics.
+ * Handler time is measured in TSC cycles on x86 and nanoseconds elsewhere.
+ * Instrumented runs also write the JSON report to the file named by the
+ * SIMSCRIPT_COUNTERS environment variable when they return. A run inside
+ * replication_run writes "<SIMSCRIPT_COUNTERS>.<replication index>", one
+ * file per replication; any other run overwrites the file itself, writes
+ * serialized so the last run to return leaves one complete report. */
+
+#define SIM_COUNTER_EVENT_TYPES (EVENT_CUSTOM + 1)
+#define SIM_COUNTER_BUCKETS 32     /* Histogram bucket i counts values in [2^i - 1, 2^(i+1) - 1) */
+
+typedef struct SimCounters {
+    uint64_t scheduled[SIM_COUNTER_EVENT_TYPES];
+    uint64_t dispatched[SIM_COUNTER_EVENT_TYPES];
+    uint64_t cancelled[SIM_COUNTER_EVENT_TYPES];
+    uint64_t queue_depth[SIM_COUNTER_BUCKETS];     /* Queue size seen by each dispatch */
+    uint64_t handler_time[SIM_COUNTER_BUCKETS];    /* Ticks spent per handler call */
+    uint64_t handler_time_total;
+} SimCounters;
+
+#ifdef SIM_INSTRUMENT
+
+#define SIM_COUNT(statement) do { statement; } while (0)
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline uint64_t sim_counter_ticks(void) {
+    return __rdtsc();
+}
+#else
+#include <time.h>
+static inline uint64_t sim_counter_ticks(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+#endif
+
+static inline int sim_counter_bucket(uint64_t value) {
+    int bucket = 63 - __builtin_clzll(value + 1);
+    return bucket < SIM_COUNTER_BUCKETS ? bucket : SIM_COUNTER_BUCKETS - 1;
+}
+
+static inline int sim_counter_type(EventType type) {
+    return ((unsigned)type < SIM_COUNTER_EVENT_TYPES) ? (int)type : EVENT_CUSTOM;
+}
+
+#else
+
+#define SIM_COUNT(statement) ((void)0)
+
+#endif
+
+/* The simulator's counters, NULL when built without SIM_INSTRUMENT */
+SimCounters* simulator_get_counters(Simulator* sim);
+
+/* Human-readable report: basic statistics, outputs and, when built in,
+ * the counters */
+void simulator_print_report(Simulator* sim);
+
+/* The same report as one JSON object */
+bool simulator_write_report_json(Simulator* sim, FILE* out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,122 @@
+#include "sim_inbox.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+
+/* Producers swap themselves into head; the consumer follows links from
+ * tail. A stub event keeps the list non-empty, so a push never touches
+ * tail and a pop never touches head except to re-insert the stub. */
+typedef struct SimInbox {
+    _Alignas(64) _Atomic(Event*) head;  /* Most recently pushed, shared by producers */
+    _Alignas(64) Event* tail;           /* Oldest not yet popped, consumer only */
+    Event stub;
+} SimInbox;
+
+/* Event::next doubles as the inbox link; while an event sits in the inbox
+ * nothing else reads it, so it is accessed atomically through this view */
+static _Atomic(Event*)* inbox_link(Event* event) {
+    return (_Atomic(Event*)*)&event->next;
+}
+
+static void inbox_push(SimInbox* inbox, Event* event) {
+    atomic_store_explicit(inbox_link(event), NULL, memory_order_relaxed);
+    Event* previous = atomic_exchange_explicit(&inbox->head, event, memory_order_acq_rel);
+    /* Until this store the consumer sees the list end at previous */
+    atomic_store_explicit(inbox_link(previous), event, memory_order_release);
+}
+
+/* NULL when empty, or when a producer is between its two steps */
+static Event* inbox_pop(SimInbox* inbox) {
+    Event* tail = inbox->tail;
+    Event* next = atomic_load_explicit(inbox_link(tail), memory_order_acquire);
+
+    if (tail == &inbox->stub) {
+        if (next == NULL) {
+            return NULL;
+        }
+        inbox->tail = next;
+        tail = next;
+        next = atomic_load_explicit(inbox_link(tail), memory_order_acquire);
+    }
+
+    if (next != NULL) {
+        inbox->tail = next;
+        return tail;
+    }
+
+    if (tail != atomic_load_explicit(&inbox->head, memory_order_acquire)) {
+        return NULL;
+    }
+
+    /* tail is the last event: push the stub behind it so it can be popped */
+    inbox_push(inbox, &inbox->stub);
+    next = atomic_load_explicit(inbox_link(tail), memory_order_acquire);
+    if (next != NULL) {
+        inbox->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+bool simulator_open_inbox(Simulator* sim) {
+    if (sim == NULL) {
+        return false;
+    }
+    if (sim->inbox != NULL) {
+        return true;
+    }
+
+    SimInbox* inbox = (SimInbox*)aligned_alloc(64, sizeof(SimInbox));
+    if (inbox == NULL) {
+        return false;
+    }
+
+    atomic_init(inbox_link(&inbox->stub), NULL);
+    atomic_init(&inbox->head, &inbox->stub);
+    inbox->tail = &inbox->stub;
+    sim->inbox = inbox;
+    return true;
+}
+
+bool simulator_inject_event(Simulator* sim, Event* event) {
+    if (sim == NULL || sim->inbox == NULL || event == NULL || event->pool != NULL) {
+        return false;
+    }
+
+    inbox_push(sim->inbox, event);
+    return true;
+}
+
+int simulator_drain_inbox(Simulator* sim) {
+    if (sim == NULL || sim->inbox == NULL) {
+        return 0;
+    }
+
+    int delivered = 0;
+    SimTime now = sim->clock->current_time;
+    Event* event;
+    while ((event = inbox_pop(sim->inbox)) != NULL) {
+        event->next = NULL;
+        if (event->time < now) {
+            event->time = now;
+        }
+        if (event_handle_is_valid(simulator_schedule_event(sim, event))) {
+            delivered++;
+        } else {
+            event_destroy(event);
+        }
+    }
+    return delivered;
+}
+
+void simulator_close_inbox(Simulator* sim) {
+    if (sim == NULL || sim->inbox == NULL) {
+        return;
+    }
+
+    Event* event;
+    while ((event = inbox_pop(sim->inbox)) != NULL) {
+        event_destroy(event);
+    }
+    free(sim->inbox);
+    sim->inbox = NULL;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "time_simulation.h"
+
+/* Lock-free event injection into a running Simulator for SIMSCRIPT.
+ *
+ * Producer threads push events into a per-simulator multi-producer,
+ * single-consumer inbox (Vyukov's intrusive queue, linked through
+ * Event::next): a push is one atomic exchange and never blocks or waits
+ * for the simulation thread. The simulation thread moves everything
+ * pushed so far into its EventQueue before each dispatch (simulator_run,
+ * simulator_step, simulator_run_until_precision) or each batch
+ * (simulator_run_batched). Events stamped before the simulator's current
+ * time are delivered at the current time. Delivery order among producers
+ * depends on thread timing, so runs with injection are not reproducible
+ * bit for bit. */
+
+/* Create the inbox; call before any producer thread starts */
+bool simulator_open_inbox(Simulator* sim);
+
+/* Thread-safe: hand event to sim. The event must come from event_create or
+ * event_create_with_payload (simulator pools are not thread-safe) and now
+ * belongs to the simulator. */
+bool simulator_inject_event(Simulator* sim, Event* event);
+
+/* Simulation thread: schedule every event pushed so far; returns how many.
+ * The run loops call this themselves. */
+int simulator_drain_inbox(Simulator* sim);
+
+/* Free the inbox and any undelivered events; producers must have stopped.
+ * simulator_destroy calls this. */
+void simulator_close_inbox(Simulator* sim);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,344 @@
+#include "sim_trace.h"
+#include "checkpoint.h"
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SIM_TRACE_MAGIC UINT64_C(0x3145434152545353)  /* "SSTRACE1" */
+#define SIM_TRACE_VERSION 1
+
+#ifdef SIM_TIME_INTEGER
+#define SIM_TRACE_TIME_FORMAT 1
+#define SIM_TRACE_TIME_RESOLUTION SIM_TIME_RESOLUTION
+#else
+#define SIM_TRACE_TIME_FORMAT 0
+#define SIM_TRACE_TIME_RESOLUTION 0
+#endif
+
+/* Word-at-a-time multiply-xorshift; payloads are small */
+static uint64_t payload_hash(const Event* event) {
+    if (event->payload_size == 0 || event->data == NULL) {
+        return 0;
+    }
+
+    const unsigned char* bytes = (const unsigned char*)event->data;
+    size_t size = event->payload_size;
+    uint64_t hash = UINT64_C(0x9e3779b97f4a7c15) ^ size;
+    while (size >= sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        hash = (hash ^ word) * UINT64_C(0xff51afd7ed558ccd);
+        hash ^= hash >> 32;
+        bytes += sizeof(word);
+        size -= sizeof(word);
+    }
+    if (size > 0) {
+        uint64_t word = 0;
+        memcpy(&word, bytes, size);
+        hash = (hash ^ word) * UINT64_C(0xff51afd7ed558ccd);
+        hash ^= hash >> 32;
+    }
+    return hash != 0 ? hash : 1;
+}
+
+static void fill_record(SimTraceRecord* record, const Event* event) {
+    record->time = event->time;
+    record->payload_hash = payload_hash(event);
+    record->type = (uint32_t)event->type;
+    record->handler_id = event_handler_id(event->handler);
+    record->sequence = event->sequence;
+}
+
+static SimTrace* trace_map(int fd, size_t map_size, SimTraceMode mode) {
+    SimTrace* trace = (SimTrace*)malloc(sizeof(SimTrace));
+    if (trace == NULL) {
+        return NULL;
+    }
+
+    int protection = mode == SIM_TRACE_RECORD ? PROT_READ | PROT_WRITE : PROT_READ;
+    void* map = mmap(NULL, map_size, protection, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        free(trace);
+        return NULL;
+    }
+
+    trace->mode = mode;
+    trace->fd = fd;
+    trace->map = map;
+    trace->map_size = map_size;
+    trace->header = (SimTraceHeader*)map;
+    trace->records = (SimTraceRecord*)((char*)map + sizeof(SimTraceHeader));
+    trace->capacity = trace->header->capacity;
+    trace->next_slot = 0;
+    trace->stop_index = SIM_TRACE_NO_INDEX;
+    trace->divergence_index = SIM_TRACE_NO_INDEX;
+    trace->checkpoint_prefix = NULL;
+    return trace;
+}
+
+SimTrace* sim_trace_create(const char* path, uint64_t capacity) {
+    if (path == NULL || capacity == 0) {
+        return NULL;
+    }
+
+    size_t map_size = sizeof(SimTraceHeader) + (size_t)capacity * sizeof(SimTraceRecord);
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)map_size) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    SimTraceHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SIM_TRACE_MAGIC;
+    header.version = SIM_TRACE_VERSION;
+    header.record_size = sizeof(SimTraceRecord);
+    header.capacity = capacity;
+    header.time_format = SIM_TRACE_TIME_FORMAT;
+    header.time_resolution = SIM_TRACE_TIME_RESOLUTION;
+    if (pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+        close(fd);
+        return NULL;
+    }
+
+    SimTrace* trace = trace_map(fd, map_size, SIM_TRACE_RECORD);
+    if (trace == NULL) {
+        close(fd);
+    }
+    return trace;
+}
+
+SimTrace* sim_trace_open(const char* path) {
+    if (path == NULL) {
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    SimTraceHeader header;
+    struct stat info;
+    if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        fstat(fd, &info) != 0 ||
+        header.magic != SIM_TRACE_MAGIC || header.version != SIM_TRACE_VERSION ||
+        header.record_size != sizeof(SimTraceRecord) ||
+        header.time_format != SIM_TRACE_TIME_FORMAT ||
+        header.time_resolution != SIM_TRACE_TIME_RESOLUTION ||
+        header.capacity == 0 ||
+        (uint64_t)info.st_size < sizeof(SimTraceHeader) + header.capacity * sizeof(SimTraceRecord)) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t map_size = sizeof(SimTraceHeader) + (size_t)header.capacity * sizeof(SimTraceRecord);
+    SimTrace* trace = trace_map(fd, map_size, SIM_TRACE_REPLAY);
+    if (trace == NULL) {
+        close(fd);
+    }
+    return trace;
+}
+
+void sim_trace_close(SimTrace* trace) {
+    if (trace == NULL) {
+        return;
+    }
+
+    if (trace->mode == SIM_TRACE_RECORD) {
+        msync(trace->map, trace->map_size, MS_SYNC);
+    }
+    munmap(trace->map, trace->map_size);
+    close(trace->fd);
+    free(trace->checkpoint_prefix);
+    free(trace);
+}
+
+void simulator_set_trace(Simulator* sim, SimTrace* trace) {
+    if (sim == NULL) {
+        return;
+    }
+
+    sim->trace = trace;
+    if (trace != NULL && trace->mode == SIM_TRACE_RECORD) {
+        /* Start the recording at this simulator's event index */
+        trace->header->start = sim->dispatched;
+        trace->header->written = sim->dispatched;
+        trace->next_slot = sim->dispatched % trace->capacity;
+    }
+}
+
+bool sim_trace_set_checkpoints(SimTrace* trace, const char* prefix, uint64_t interval) {
+    if (trace == NULL || trace->mode != SIM_TRACE_RECORD) {
+        return false;
+    }
+
+    char* copy = NULL;
+    if (prefix != NULL && interval > 0) {
+        copy = strdup(prefix);
+        if (copy == NULL) {
+            return false;
+        }
+    }
+    free(trace->checkpoint_prefix);
+    trace->checkpoint_prefix = copy;
+    trace->header->checkpoint_interval = (copy != NULL) ? interval : 0;
+    return true;
+}
+
+static void checkpoint_path(char* path, size_t size, const char* prefix, uint64_t index) {
+    snprintf(path, size, "%s.%" PRIu64, prefix, index);
+}
+
+Simulator* sim_trace_restore(SimTrace* trace, const char* prefix, uint64_t index) {
+    if (trace == NULL || prefix == NULL || trace->mode != SIM_TRACE_REPLAY) {
+        return NULL;
+    }
+
+    uint64_t interval = trace->header->checkpoint_interval;
+    uint64_t start = trace->header->start;
+    if (interval == 0 || index < start) {
+        return NULL;
+    }
+
+    size_t size = strlen(prefix) + 24;
+    char* path = (char*)malloc(size);
+    if (path == NULL) {
+        return NULL;
+    }
+
+    /* Latest checkpoint first; skipped ones fall back to earlier ones */
+    Simulator* sim = NULL;
+    uint64_t at = index - index % interval;
+    while (at >= start) {
+        checkpoint_path(path, size, prefix, at);
+        sim = simulator_restore(path);
+        if (sim != NULL || at < interval) {
+            break;
+        }
+        at -= interval;
+    }
+    free(path);
+
+    if (sim != NULL) {
+        simulator_set_trace(sim, trace);
+        trace->stop_index = index;
+        trace->divergence_index = SIM_TRACE_NO_INDEX;
+    }
+    return sim;
+}
+
+static void trace_checkpoint(Simulator* sim, SimTrace* trace, uint64_t index) {
+    size_t size = strlen(trace->checkpoint_prefix) + 24;
+    char* path = (char*)malloc(size);
+    if (path != NULL) {
+        checkpoint_path(path, size, trace->checkpoint_prefix, index);
+    }
+    if (path == NULL || !simulator_checkpoint(sim, path)) {
+        if (trace->header->checkpoint_failures < UINT32_MAX) {
+            trace->header->checkpoint_failures++;
+        }
+    }
+    free(path);
+}
+
+uint64_t sim_trace_checkpoint_failures(SimTrace* trace) {
+    return (trace != NULL) ? trace->header->checkpoint_failures : 0;
+}
+
+uint64_t sim_trace_written(SimTrace* trace) {
+    return (trace != NULL) ? trace->header->written : 0;
+}
+
+uint64_t sim_trace_first(SimTrace* trace) {
+    if (trace == NULL) {
+        return 0;
+    }
+    uint64_t written = trace->header->written;
+    uint64_t oldest = written > trace->capacity ? written - trace->capacity : 0;
+    return oldest > trace->header->start ? oldest : trace->header->start;
+}
+
+const SimTraceRecord* sim_trace_get(SimTrace* trace, uint64_t index) {
+    if (trace == NULL || index < sim_trace_first(trace) || index >= trace->header->written) {
+        return NULL;
+    }
+    return &trace->records[index % trace->capacity];
+}
+
+uint64_t sim_trace_seek(SimTrace* trace, SimTime time) {
+    if (trace == NULL) {
+        return 0;
+    }
+
+    /* Dispatch times never decrease, so the retained window is sorted */
+    uint64_t low = sim_trace_first(trace);
+    uint64_t high = trace->header->written;
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        if (trace->records[middle % trace->capacity].time < time) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+void sim_trace_set_stop(SimTrace* trace, uint64_t index) {
+    if (trace != NULL) {
+        trace->stop_index = index;
+    }
+}
+
+bool sim_trace_before_dispatch(Simulator* sim, Event* event) {
+    SimTrace* trace = sim->trace;
+    uint64_t index = sim->dispatched;
+
+    if (trace->mode == SIM_TRACE_RECORD) {
+        /* Between steps, so the checkpoint holds the event still queued */
+        if (trace->checkpoint_prefix != NULL &&
+            index % trace->header->checkpoint_interval == 0) {
+            trace_checkpoint(sim, trace, index);
+        }
+        fill_record(&trace->records[trace->next_slot], event);
+        if (++trace->next_slot == trace->capacity) {
+            trace->next_slot = 0;
+        }
+        trace->header->written = index + 1;
+        return true;
+    }
+
+    if (index == trace->stop_index) {
+        trace->stop_index = SIM_TRACE_NO_INDEX;  /* Resuming continues past it */
+        return false;
+    }
+
+    /* Only the first divergence is reported; later events are not checked */
+    if (trace->divergence_index != SIM_TRACE_NO_INDEX) {
+        return true;
+    }
+
+    const SimTraceRecord* expected = sim_trace_get(trace, index);
+    if (expected == NULL) {
+        return true;  /* Before the retained window, or past the end of the recording */
+    }
+
+    SimTraceRecord actual;
+    fill_record(&actual, event);
+    if (actual.time != expected->time || actual.type != expected->type ||
+        actual.handler_id != expected->handler_id ||
+        actual.payload_hash != expected->payload_hash) {
+        trace->divergence_index = index;
+        return false;
+    }
+    return true;
+}
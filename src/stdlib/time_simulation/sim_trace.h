@@ -0,0 +1,120 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "time_simulation.h"
+
+/* Event trace recording and replay for SIMSCRIPT.
+ *
+ * A recording simulator appends one fixed-size record per dispatched event
+ * to a ring in a memory-mapped file, so the last capacity events survive a
+ * crash without any write calls on the hot path. A replaying simulator
+ * re-executes the model, checks every dispatched event against the record
+ * with the same index and pauses before the first event that differs, or
+ * before a chosen stop index; sim_trace_seek finds the index where a time
+ * window starts.
+ *
+ * Replay re-runs handlers rather than re-feeding records, so on its own it
+ * starts from the beginning. To jump to a window, record with periodic
+ * checkpoints (sim_trace_set_checkpoints); sim_trace_restore then resumes
+ * from the last checkpoint before the window and replays only the events
+ * between the two. Handlers are identified by their registry id
+ * (event_handler_register), so register them in the same order in both
+ * runs. */
+
+#define SIM_TRACE_NO_INDEX UINT64_MAX
+
+/* File header, followed by capacity records */
+typedef struct SimTraceHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;         /* Records in the ring */
+    uint64_t written;          /* Records written in total; the newest capacity are kept */
+    uint32_t time_format;      /* 0 = double, 1 = integer ticks */
+    uint32_t checkpoint_failures; /* Checkpoints that could not be written, saturating */
+    uint64_t time_resolution;  /* Ticks per time unit in integer format */
+    uint64_t start;            /* Index of the first event recorded */
+    uint64_t checkpoint_interval; /* Events between checkpoints, 0 for none */
+} SimTraceHeader;
+
+/* One dispatched event */
+typedef struct SimTraceRecord {
+    SimTime time;
+    uint64_t payload_hash;     /* Hash of the copied payload, 0 without one */
+    uint32_t type;
+    uint32_t handler_id;
+    uint64_t sequence;         /* Queue tie-break key */
+} SimTraceRecord;
+
+typedef enum {
+    SIM_TRACE_RECORD,
+    SIM_TRACE_REPLAY
+} SimTraceMode;
+
+typedef struct SimTrace {
+    SimTraceMode mode;
+    int fd;
+    void* map;
+    size_t map_size;
+    SimTraceHeader* header;
+    SimTraceRecord* records;
+    uint64_t capacity;
+    uint64_t next_slot;        /* Ring position of the next record (recording) */
+    uint64_t stop_index;       /* Replay pauses before this event */
+    uint64_t divergence_index; /* First event that differed from the recording */
+    char* checkpoint_prefix;   /* Checkpoints are written as "<prefix>.<index>" */
+} SimTrace;
+
+/* Create a trace file holding the last capacity events, for recording */
+SimTrace* sim_trace_create(const char* path, uint64_t capacity);
+
+/* Open a recorded trace read-only, for replay */
+SimTrace* sim_trace_open(const char* path);
+
+/* Flush and unmap */
+void sim_trace_close(SimTrace* trace);
+
+/* Attach a trace (NULL detaches); replay compares event i with record i,
+ * counting from the simulator's dispatched count. A recording starts at
+ * the simulator's dispatched count; earlier indices have no records. */
+void simulator_set_trace(Simulator* sim, SimTrace* trace);
+
+/* While recording, checkpoint the simulator (simulator_checkpoint) to
+ * "<prefix>.<index>" before every event whose index is a multiple of
+ * interval. A checkpoint that cannot be written (for instance while
+ * processes are alive) is skipped and counted in the header, so both the
+ * recording and the replaying run see it (sim_trace_checkpoint_failures). */
+bool sim_trace_set_checkpoints(SimTrace* trace, const char* prefix, uint64_t interval);
+
+/* Fast-forward for replay: restore the last checkpoint taken at or before
+ * event index (prefix as given when recording), attach trace to it and
+ * stop before index. NULL if the recording has no such checkpoint, e.g.
+ * because every one was skipped. */
+Simulator* sim_trace_restore(SimTrace* trace, const char* prefix, uint64_t index);
+
+/* Checkpoints skipped while recording */
+uint64_t sim_trace_checkpoint_failures(SimTrace* trace);
+
+/* Number of events recorded, and index of the oldest one still retained */
+uint64_t sim_trace_written(SimTrace* trace);
+uint64_t sim_trace_first(SimTrace* trace);
+
+/* Record for an event index, NULL if outside the retained window */
+const SimTraceRecord* sim_trace_get(SimTrace* trace, uint64_t index);
+
+/* Index of the first retained event at or after time */
+uint64_t sim_trace_seek(SimTrace* trace, SimTime time);
+
+/* Make replay pause before event index (SIM_TRACE_NO_INDEX = never) */
+void sim_trace_set_stop(SimTrace* trace, uint64_t index);
+
+/* Dispatch hook: records the event, or checks it during replay. Returns
+ * false when the simulator should pause before running it. */
+bool sim_trace_before_dispatch(Simulator* sim, Event* event);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,132 +1,133 @@
 #include "time_simulation.h"
+#include "output_analysis.h"
+#include "process.h"
+#include "replication.h"
+#include "sim_counters.h"
+#include "sim_inbox.h"
+#include "sim_trace.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
-
-/* Global simulation time (for single-threaded simulations) */
-static SimTime global_sim_time = 0.0;
-
-/* Event ID counter */
-static int next_event_id = 1;
-
-/* Event queue implementation */
-EventQueue* event_queue_create(void) {
-    EventQueue* queue = (EventQueue*)malloc(sizeof(EventQueue));
-    if (queue == NULL) {
-        return NULL;
-    }
-
-    queue->head = NULL;
-    queue->count = 0;
-    return queue;
-}
-
-void event_queue_destroy(EventQueue* queue) {
-    if (queue == NULL) {
+#ifdef SIM_INSTRUMENT
+#include <pthread.h>
+#endif
+
+#define SIMULATOR_BATCH_SIZE 256
+#define HANDLER_REGISTRY_INITIAL 64
+#define SIMULATOR_PRECISION_FIRST_CHECK 1024
+#define SIMULATOR_PRECISION_GROWTH 1.25
+
+/* Simulator running on this thread; sim_time_now reads its clock, so
+ * simulators on different threads never share state */
+static _Thread_local Simulator* current_simulator = NULL;
+
+static void simulator_dispatch(Simulator* sim);
+
+/* Runs a popped event's handler, counting it when instrumented */
+static inline void simulator_invoke(Simulator* sim, Event* event) {
+#ifdef SIM_INSTRUMENT
+    SimCounters* counters = sim->counters;
+    if (counters != NULL) {
+        counters->dispatched[sim_counter_type(event->type)]++;
+        counters->queue_depth[sim_counter_bucket((uint64_t)event_queue_size(sim->event_queue))]++;
+        if (event->handler != NULL) {
+            uint64_t start = sim_counter_ticks();
+            event->handler(event);
+            uint64_t elapsed = sim_counter_ticks() - start;
+            counters->handler_time[sim_counter_bucket(elapsed)]++;
+            counters->handler_time_total += elapsed;
+        }
         return;
     }
-
-    Event* current = queue->head;
-    while (current != NULL) {
-        Event* next = current->next;
-        event_destroy(current);
-        current = next;
+#else
+    (void)sim;
+#endif
+    if (event->handler != NULL) {
+        event->handler(event);
     }
-
-    free(queue);
 }
 
-bool event_queue_is_empty(EventQueue* queue) {
-    return queue == NULL || queue->head == NULL;
-}
+/* Handler registry: ids index handler_table; handler_slots is an
+ * open-addressing map from handler address to id */
+static EventHandler* handler_table = NULL;
+static uint32_t handler_count = 1;     /* Id 0 is the NULL handler */
+static uint32_t handler_capacity = 0;
+static uint32_t* handler_slots = NULL;
+static uint32_t handler_slot_count = 0;  /* Power of two, at least twice handler_count */
 
-void event_queue_schedule(EventQueue* queue, Event* event) {
-    if (queue == NULL || event == NULL) {
-        return;
-    }
-
-    event->event_id = next_event_id++;
-
-    if (queue->head == NULL || event->time < queue->head->time) {
-        event->next = queue->head;
-        queue->head = event;
-    } else {
-        Event* current = queue->head;
-        while (current->next != NULL && current->next->time <= event->time) {
-            current = current->next;
-        }
-        event->next = current->next;
-        current->next = event;
-    }
-
-    queue->count++;
+/* Event management */
+static void event_init(Event* event, SimTime time, EventType type, void* data,
+                       void (*handler)(Event*)) {
+    event->time = time;
+    event->type = type;
+    event->event_id = 0;  /* Will be set by event_queue_schedule */
+    event->data = data;
+    event->handler = handler;
+    event->next = NULL;
+    event->child = NULL;
+    event->prev = NULL;
+    event->sequence = 0;  /* Will be set by event_queue_schedule */
+    event->handle_index = EVENT_HANDLE_INVALID_INDEX;
+    event->payload_size = 0;
+    event->cancelled = false;
+    event->in_batch = false;
+    event->retained = false;
+    event->owns_data = false;
+    event->pool = NULL;
+    event->context = NULL;
 }
 
-Event* event_queue_next(EventQueue* queue) {
-    if (event_queue_is_empty(queue)) {
+Event* event_create(SimTime time, EventType type, void* data,
+                   void (*handler)(Event*)) {
+    Event* event = (Event*)malloc(sizeof(Event));
+    if (event == NULL) {
         return NULL;
     }
 
-    Event* event = queue->head;
-    queue->head = event->next;
-    queue->count--;
-
-    event->next = NULL;
+    event_init(event, time, type, data, handler);
     return event;
 }
 
-Event* event_queue_peek(EventQueue* queue) {
-    return (queue != NULL) ? queue->head : NULL;
-}
-
-void event_queue_cancel(EventQueue* queue, int event_id) {
-    if (queue == NULL || queue->head == NULL) {
-        return;
+/* Copies the payload into the event; larger payloads share its allocation */
+Event* event_create_with_payload(SimTime time, EventType type,
+                                 const void* payload, size_t size,
+                                 void (*handler)(Event*)) {
+    size_t extra = size > EVENT_INLINE_PAYLOAD_SIZE ? size : 0;
+    Event* event = (Event*)malloc(sizeof(Event) + extra);
+    if (event == NULL) {
+        return NULL;
     }
 
-    if (queue->head->event_id == event_id) {
-        Event* cancelled = queue->head;
-        queue->head = cancelled->next;
-        queue->count--;
-        event_destroy(cancelled);
-        return;
+    void* storage = extra > 0 ? (void*)(event + 1) : (void*)event->payload;
+    if (payload != NULL && size > 0) {
+        memcpy(storage, payload, size);
     }
 
-    Event* current = queue->head;
-    while (current->next != NULL) {
-        if (current->next->event_id == event_id) {
-            Event* cancelled = current->next;
-            current->next = cancelled->next;
-            queue->count--;
-            event_destroy(cancelled);
-            return;
-        }
-        current = current->next;
-    }
+    event_init(event, time, type, storage, handler);
+    event->payload_size = (uint32_t)size;
+    return event;
 }
 
-/* Event management */
-Event* event_create(SimTime time, EventType type, void* data,
-                   void (*handler)(Event*)) {
-    Event* event = (Event*)malloc(sizeof(Event));
+void event_destroy(Event* event) {
     if (event == NULL) {
-        return NULL;
+        return;
     }
 
-    event->time = time;
-    event->type = type;
-    event->event_id = 0;  /* Will be set by event_queue_schedule */
-    event->data = data;
-    event->handler = handler;
-    event->next = NULL;
+    if (event->owns_data) {
+        free(event->data);
+    }
 
-    return event;
+    if (event->pool != NULL) {
+        event_pool_free(event->pool, event);
+    } else {
+        free(event);
+    }
 }
 
-void event_destroy(Event* event) {
+void event_retain(Event* event) {
     if (event != NULL) {
-        free(event);
+        event->retained = true;
     }
 }
 
@@ -138,11 +139,10 @@ SimClock* sim_clock_create(SimTime start_time, SimTime end_time) {
     }
 
     clock->current_time = start_time;
+    clock->start_time = start_time;
     clock->end_time = end_time;
     clock->running = false;
 
-    global_sim_time = start_time;
-
     return clock;
 }
 
@@ -153,12 +153,11 @@ void sim_clock_destroy(SimClock* clock) {
 }
 
 void sim_clock_advance(SimClock* clock, SimTime delta) {
-    if (clock == NULL || delta < 0.0) {
+    if (clock == NULL || delta < SIM_TIME_ZERO) {
         return;
     }
 
     clock->current_time += delta;
-    global_sim_time = clock->current_time;
 }
 
 bool sim_clock_is_finished(SimClock* clock) {
@@ -166,7 +165,7 @@ bool sim_clock_is_finished(SimClock* clock) {
 }
 
 SimTime sim_clock_get_time(SimClock* clock) {
-    return (clock != NULL) ? clock->current_time : global_sim_time;
+    return (clock != NULL) ? clock->current_time : sim_time_now();
 }
 
 /* Statistics */
@@ -178,14 +177,18 @@ SimStats* sim_stats_create(void) {
 
     stats->total_events = 0;
     stats->processed_events = 0;
-    stats->total_time = 0.0;
-    stats->idle_time = 0.0;
+    stats->total_time = SIM_TIME_ZERO;
+    stats->idle_time = SIM_TIME_ZERO;
+    stats->outputs = NULL;
+    stats->output_count = 0;
+    stats->output_capacity = 0;
 
     return stats;
 }
 
 void sim_stats_destroy(SimStats* stats) {
     if (stats != NULL) {
+        free(stats->outputs);
         free(stats);
     }
 }
@@ -205,6 +208,26 @@ void sim_stats_record_idle_time(SimStats* stats, SimTime idle_time) {
     }
 }
 
+bool sim_stats_add_output(SimStats* stats, OutputStat* output) {
+    if (stats == NULL || output == NULL) {
+        return false;
+    }
+
+    if (stats->output_count == stats->output_capacity) {
+        int capacity = stats->output_capacity > 0 ? stats->output_capacity * 2 : 4;
+        OutputStat** outputs = (OutputStat**)realloc(stats->outputs,
+                                                     (size_t)capacity * sizeof(OutputStat*));
+        if (outputs == NULL) {
+            return false;
+        }
+        stats->outputs = outputs;
+        stats->output_capacity = capacity;
+    }
+
+    stats->outputs[stats->output_count++] = output;
+    return true;
+}
+
 void sim_stats_print(SimStats* stats) {
     if (stats == NULL) {
         return;
@@ -213,25 +236,237 @@ void sim_stats_print(SimStats* stats) {
     printf("Simulation Statistics:\n");
     printf("  Total Events: %d\n", stats->total_events);
     printf("  Processed Events: %d\n", stats->processed_events);
-    printf("  Total Simulation Time: %.3f\n", stats->total_time);
+    double total_time = sim_time_to_double(stats->total_time);
+    double idle_time = sim_time_to_double(stats->idle_time);
+    printf("  Total Simulation Time: %.3f\n", total_time);
     printf("  Idle Time: %.3f (%.1f%%)\n",
-           stats->idle_time,
-           stats->total_time > 0.0 ? (stats->idle_time / stats->total_time) * 100.0 : 0.0);
+           idle_time,
+           total_time > 0.0 ? (idle_time / total_time) * 100.0 : 0.0);
+
+    for (int i = 0; i < stats->output_count; i++) {
+        output_stat_print(stats->outputs[i]);
+    }
+}
+
+/* Time-weighted statistics */
+void time_weighted_init(TimeWeightedStat* stat, SimTime time, double value) {
+    if (stat == NULL) {
+        return;
+    }
+
+    stat->clock = NULL;
+    stat->owner = NULL;
+    stat->owner_index = -1;
+    stat->value = value;
+    stat->start_time = time;
+    stat->last_time = time;
+    stat->area = 0.0;
+    stat->area_sq = 0.0;
+    stat->min = value;
+    stat->max = value;
+}
+
+void time_weighted_set(TimeWeightedStat* stat, SimTime time, double value) {
+    if (stat == NULL) {
+        return;
+    }
+
+    if (time > stat->last_time) {
+        double elapsed = sim_time_to_double(time - stat->last_time);
+        stat->area += stat->value * elapsed;
+        stat->area_sq += stat->value * stat->value * elapsed;
+        stat->last_time = time;
+    }
+
+    stat->value = value;
+    if (value < stat->min) {
+        stat->min = value;
+    }
+    if (value > stat->max) {
+        stat->max = value;
+    }
+}
+
+void time_weighted_restart(TimeWeightedStat* stat) {
+    if (stat == NULL) {
+        return;
+    }
+
+    SimTime time = sim_clock_get_time(stat->clock);
+    stat->start_time = time;
+    stat->last_time = time;
+    stat->area = 0.0;
+    stat->area_sq = 0.0;
+    stat->min = stat->value;
+    stat->max = stat->value;
+}
+
+void time_weighted_unbind(TimeWeightedStat* stat) {
+    if (stat == NULL) {
+        return;
+    }
+
+    Simulator* owner = stat->owner;
+    if (owner != NULL) {
+        TimeWeightedStat* last = owner->bound_stats[--owner->bound_stat_count];
+        owner->bound_stats[stat->owner_index] = last;
+        last->owner_index = stat->owner_index;
+    }
+    stat->clock = NULL;
+    stat->owner = NULL;
+    stat->owner_index = -1;
+}
+
+/* Records stat in sim's list so simulator_destroy can unbind it */
+static bool time_weighted_attach(TimeWeightedStat* stat, Simulator* sim) {
+    if (sim->bound_stat_count == sim->bound_stat_capacity) {
+        int new_capacity = sim->bound_stat_capacity > 0 ? sim->bound_stat_capacity * 2 : 8;
+        TimeWeightedStat** stats = (TimeWeightedStat**)realloc(
+            sim->bound_stats, (size_t)new_capacity * sizeof(TimeWeightedStat*));
+        if (stats == NULL) {
+            return false;
+        }
+        sim->bound_stats = stats;
+        sim->bound_stat_capacity = new_capacity;
+    }
+
+    stat->owner = sim;
+    stat->owner_index = sim->bound_stat_count;
+    sim->bound_stats[sim->bound_stat_count++] = stat;
+    stat->clock = sim->clock;
+    return true;
+}
+
+void time_weighted_bind(TimeWeightedStat* stat, SimClock* clock) {
+    if (stat == NULL) {
+        return;
+    }
+
+    time_weighted_unbind(stat);
+    stat->clock = clock;
+    time_weighted_restart(stat);
+}
+
+void time_weighted_bind_simulator(TimeWeightedStat* stat, Simulator* sim) {
+    if (stat == NULL) {
+        return;
+    }
+
+    time_weighted_unbind(stat);
+    if (sim != NULL && !time_weighted_attach(stat, sim)) {
+        /* Without a list entry the clock could outlive sim: stay unbound */
+        stat->clock = NULL;
+    }
+    time_weighted_restart(stat);
+}
+
+/* The stat's clock, binding it to the current simulator on first use.
+ * If the binding cannot be recorded the clock is used unbound. */
+static SimClock* time_weighted_clock(TimeWeightedStat* stat) {
+    if (stat->clock == NULL) {
+        Simulator* sim = simulator_current();
+        if (sim == NULL) {
+            return NULL;
+        }
+        if (stat->area == 0.0 && stat->last_time == stat->start_time &&
+            stat->start_time < sim->clock->start_time) {
+            /* Created before the simulator existed: start with it */
+            stat->start_time = sim->clock->start_time;
+            stat->last_time = sim->clock->start_time;
+        }
+        if (!time_weighted_attach(stat, sim)) {
+            return sim->clock;
+        }
+    }
+    return stat->clock;
+}
+
+void time_weighted_set_now(TimeWeightedStat* stat, double value) {
+    if (stat == NULL) {
+        return;
+    }
+    time_weighted_set(stat, sim_clock_get_time(time_weighted_clock(stat)), value);
+}
+
+/* Integrals up to time, counting the value currently held */
+static double time_weighted_span(const TimeWeightedStat* stat, SimTime time,
+                                 double* area, double* area_sq) {
+    double pending = (time > stat->last_time) ? sim_time_to_double(time - stat->last_time) : 0.0;
+    *area = stat->area + stat->value * pending;
+    *area_sq = stat->area_sq + stat->value * stat->value * pending;
+    SimTime end = (time > stat->last_time) ? time : stat->last_time;
+    return sim_time_to_double(end - stat->start_time);
+}
+
+double time_weighted_mean(const TimeWeightedStat* stat, SimTime time) {
+    if (stat == NULL) {
+        return 0.0;
+    }
+
+    double area, area_sq;
+    double span = time_weighted_span(stat, time, &area, &area_sq);
+    return span > 0.0 ? area / span : stat->value;
+}
+
+double time_weighted_variance(const TimeWeightedStat* stat, SimTime time) {
+    if (stat == NULL) {
+        return 0.0;
+    }
+
+    double area, area_sq;
+    double span = time_weighted_span(stat, time, &area, &area_sq);
+    if (span <= 0.0) {
+        return 0.0;
+    }
+    double mean = area / span;
+    double variance = area_sq / span - mean * mean;
+    return variance > 0.0 ? variance : 0.0;
+}
+
+double time_weighted_mean_now(const TimeWeightedStat* stat) {
+    if (stat == NULL) {
+        return 0.0;
+    }
+    return time_weighted_mean(stat, sim_clock_get_time(stat->clock));
+}
+
+double time_weighted_min(const TimeWeightedStat* stat) {
+    return (stat != NULL) ? stat->min : 0.0;
+}
+
+double time_weighted_max(const TimeWeightedStat* stat) {
+    return (stat != NULL) ? stat->max : 0.0;
 }
 
 /* Simulator */
 Simulator* simulator_create(SimTime start_time, SimTime end_time) {
+    return simulator_create_with_engine(start_time, end_time, EVENT_QUEUE_DEFAULT_ENGINE);
+}
+
+Simulator* simulator_create_with_engine(SimTime start_time, SimTime end_time,
+                                        EventQueueEngine engine) {
     Simulator* sim = (Simulator*)malloc(sizeof(Simulator));
     if (sim == NULL) {
         return NULL;
     }
 
     sim->clock = sim_clock_create(start_time, end_time);
-    sim->event_queue = event_queue_create();
+    sim->event_queue = event_queue_create_with_engine(engine);
     sim->stats = sim_stats_create();
+    sim->event_pool = event_pool_create(0);
+    sim->trace = NULL;
+    sim->processes = NULL;
+    sim->inbox = NULL;
+    sim->counters = NULL;
+    sim->bound_stats = NULL;
+    sim->bound_stat_count = 0;
+    sim->bound_stat_capacity = 0;
+    sim->dispatched = 0;
     sim->paused = false;
+    SIM_COUNT(sim->counters = (SimCounters*)calloc(1, sizeof(SimCounters)));
 
-    if (sim->clock == NULL || sim->event_queue == NULL || sim->stats == NULL) {
+    if (sim->clock == NULL || sim->event_queue == NULL || sim->stats == NULL ||
+        sim->event_pool == NULL) {
         simulator_destroy(sim);
         return NULL;
     }
@@ -239,24 +474,147 @@ Simulator* simulator_create(SimTime start_time, SimTime end_time) {
     return sim;
 }
 
+#ifdef SIM_INSTRUMENT
+static pthread_mutex_t counters_export_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* At the end of each run, instrumented builds write the JSON report to
+ * $SIMSCRIPT_COUNTERS, if set, so compiled programs report without calling
+ * anything. A replication writes to "<path>.<index>" so concurrent
+ * replications never share a file; other runs write the path itself one
+ * at a time, the last to return winning. */
+static void simulator_export_counters(Simulator* sim) {
+    const char* path = getenv("SIMSCRIPT_COUNTERS");
+    if (path == NULL || *path == '\0') {
+        return;
+    }
+
+    Replication* replication = replication_current();
+    if (replication != NULL && replication->sim == sim) {
+        size_t size = strlen(path) + 16;
+        char* indexed = (char*)malloc(size);
+        if (indexed == NULL) {
+            return;
+        }
+        snprintf(indexed, size, "%s.%d", path, replication->index);
+        FILE* out = fopen(indexed, "w");
+        if (out != NULL) {
+            simulator_write_report_json(sim, out);
+            fclose(out);
+        }
+        free(indexed);
+        return;
+    }
+
+    pthread_mutex_lock(&counters_export_lock);
+    FILE* out = fopen(path, "w");
+    if (out != NULL) {
+        simulator_write_report_json(sim, out);
+        fclose(out);
+    }
+    pthread_mutex_unlock(&counters_export_lock);
+}
+#endif
+
 void simulator_destroy(Simulator* sim) {
     if (sim == NULL) {
         return;
     }
 
+    if (current_simulator == sim) {
+        current_simulator = NULL;
+    }
+    /* Processes hand their wake events back to the queue or the pool */
+    process_destroy_all(sim);
+    simulator_close_inbox(sim);
+    free(sim->counters);
+    for (int i = 0; i < sim->bound_stat_count; i++) {
+        TimeWeightedStat* stat = sim->bound_stats[i];
+        stat->clock = NULL;
+        stat->owner = NULL;
+        stat->owner_index = -1;
+    }
+    free(sim->bound_stats);
     sim_clock_destroy(sim->clock);
+    /* Queued events may live in the pool, so the queue goes first */
     event_queue_destroy(sim->event_queue);
+    event_pool_destroy(sim->event_pool);
     sim_stats_destroy(sim->stats);
     free(sim);
 }
 
-void simulator_schedule_event(Simulator* sim, Event* event) {
+Event* simulator_create_event(Simulator* sim, SimTime time, EventType type,
+                              void* data, void (*handler)(Event*)) {
+    if (sim == NULL) {
+        return NULL;
+    }
+
+    Event* event = event_pool_alloc(sim->event_pool);
+    if (event == NULL) {
+        return NULL;
+    }
+
+    event->time = time;
+    event->type = type;
+    event->data = data;
+    event->handler = handler;
+    return event;
+}
+
+Event* simulator_create_event_with_payload(Simulator* sim, SimTime time, EventType type,
+                                           const void* payload, size_t size,
+                                           void (*handler)(Event*)) {
+    Event* event = simulator_create_event(sim, time, type, NULL, handler);
+    if (event == NULL) {
+        return NULL;
+    }
+
+    if (size <= EVENT_INLINE_PAYLOAD_SIZE) {
+        event->data = event->payload;
+    } else {
+        event->data = malloc(size);
+        if (event->data == NULL) {
+            event_destroy(event);
+            return NULL;
+        }
+        event->owns_data = true;
+    }
+
+    if (payload != NULL && size > 0) {
+        memcpy(event->data, payload, size);
+    }
+    event->payload_size = (uint32_t)size;
+    return event;
+}
+
+EventHandle simulator_schedule_event(Simulator* sim, Event* event) {
     if (sim == NULL || event == NULL) {
-        return;
+        EventHandle invalid = {EVENT_HANDLE_INVALID_INDEX, 0};
+        return invalid;
     }
 
-    event_queue_schedule(sim->event_queue, event);
-    sim_stats_record_event(sim->stats, event->type);
+    EventHandle handle = event_queue_schedule(sim->event_queue, event);
+    if (event_handle_is_valid(handle)) {
+        sim_stats_record_event(sim->stats, event->type);
+#ifdef SIM_INSTRUMENT
+        if (sim->counters != NULL) {
+            sim->counters->scheduled[sim_counter_type(event->type)]++;
+        }
+#endif
+    }
+    return handle;
+}
+
+bool simulator_cancel_event(Simulator* sim, EventHandle handle) {
+    if (sim == NULL) {
+        return false;
+    }
+#ifdef SIM_INSTRUMENT
+    Event* event = event_queue_lookup(sim->event_queue, handle);
+    if (event != NULL && sim->counters != NULL) {
+        sim->counters->cancelled[sim_counter_type(event->type)]++;
+    }
+#endif
+    return event_queue_cancel_handle(sim->event_queue, handle);
 }
 
 void simulator_run(Simulator* sim) {
@@ -264,42 +622,197 @@ void simulator_run(Simulator* sim) {
         return;
     }
 
+    Simulator* previous = simulator_set_current(sim);
     sim->clock->running = true;
     sim->paused = false;
 
     while (!sim_clock_is_finished(sim->clock) && !sim->paused) {
-        simulator_step(sim);
+        simulator_dispatch(sim);
     }
 
     sim->clock->running = false;
+    SIM_COUNT(simulator_export_counters(sim));
+    simulator_set_current(previous);
 }
 
-void simulator_step(Simulator* sim) {
-    if (sim == NULL || event_queue_is_empty(sim->event_queue)) {
+/* Precision is checked after SIMULATOR_PRECISION_FIRST_CHECK events and
+ * then whenever the event count has grown by SIMULATOR_PRECISION_GROWTH, so
+ * checks cost O(log n) over the run and overshoot by at most that factor */
+static bool simulator_outputs_precise(Simulator* sim, double confidence,
+                                      double relative_precision) {
+    SimStats* stats = sim->stats;
+    for (int i = 0; i < stats->output_count; i++) {
+        OutputStat* output = stats->outputs[i];
+        output_stat_advance(output, sim->clock->current_time);
+        if (output_stat_relative_half_width(output, confidence) > relative_precision) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool simulator_run_until_precision(Simulator* sim, double confidence,
+                                   double relative_precision) {
+    if (sim == NULL) {
+        return false;
+    }
+
+    Simulator* previous = simulator_set_current(sim);
+    sim->clock->running = true;
+    sim->paused = false;
+
+    bool precise = false;
+    bool monitored = sim->stats->output_count > 0;
+    uint64_t next_check = sim->dispatched + SIMULATOR_PRECISION_FIRST_CHECK;
+    while (!sim_clock_is_finished(sim->clock) && !sim->paused) {
+        if (sim->inbox != NULL) {
+            simulator_drain_inbox(sim);
+        }
+        if (event_queue_is_empty(sim->event_queue)) {
+            break;
+        }
+        simulator_dispatch(sim);
+
+        if (monitored && sim->dispatched >= next_check) {
+            if (simulator_outputs_precise(sim, confidence, relative_precision)) {
+                precise = true;
+                break;
+            }
+            next_check = (uint64_t)((double)sim->dispatched * SIMULATOR_PRECISION_GROWTH);
+        }
+    }
+
+    sim->clock->running = false;
+    SIM_COUNT(simulator_export_counters(sim));
+    simulator_set_current(previous);
+    return precise;
+}
+
+/* Dispatches all events due within window of the earliest one as a single
+ * batch: the clock advances once to the batch time and the end-of-run check
+ * and statistics update run once per batch. Events inside the window are
+ * treated as simultaneous. Unlike simulator_run, a pause takes effect at
+ * the end of the current batch, and the run returns when the queue drains.
+ * With a trace attached, events are dispatched one at a time so replay can
+ * stop exactly at a given event. */
+void simulator_run_batched(Simulator* sim, SimTime window) {
+    if (sim == NULL) {
         return;
     }
 
+    Event* batch[SIMULATOR_BATCH_SIZE];
+
+    Simulator* previous = simulator_set_current(sim);
+    sim->clock->running = true;
+    sim->paused = false;
+
+    while (!sim_clock_is_finished(sim->clock) && !sim->paused) {
+        if (sim->inbox != NULL) {
+            simulator_drain_inbox(sim);
+        }
+
+        if (sim->trace != NULL) {
+            if (event_queue_is_empty(sim->event_queue)) {
+                break;
+            }
+            simulator_dispatch(sim);
+            continue;
+        }
+
+        int count = event_queue_next_batch(sim->event_queue, batch,
+                                           SIMULATOR_BATCH_SIZE, window);
+        if (count == 0) {
+            break;
+        }
+
+        SimTime time_advance = batch[0]->time - sim->clock->current_time;
+        if (time_advance > SIM_TIME_ZERO) {
+            sim_clock_advance(sim->clock, time_advance);
+            sim_stats_record_idle_time(sim->stats, time_advance);
+        }
+
+        for (int i = 0; i < count; i++) {
+            Event* event = batch[i];
+            if (event->cancelled) {
+                /* Cancelled by an earlier handler in this batch */
+                event_destroy(event);
+                continue;
+            }
+
+            event_queue_complete(sim->event_queue, event);
+            sim->dispatched++;
+            simulator_invoke(sim, event);
+            if (!event->retained) {
+                event_destroy(event);
+            }
+        }
+
+        sim->stats->total_time = sim->clock->current_time;
+    }
+
+    sim->clock->running = false;
+    SIM_COUNT(simulator_export_counters(sim));
+    simulator_set_current(previous);
+}
+
+/* Pops and runs the next event; the caller has made sim current */
+static void simulator_dispatch(Simulator* sim) {
+    /* Step boundary: take in events injected by other threads */
+    if (sim->inbox != NULL) {
+        simulator_drain_inbox(sim);
+    }
+
+    if (event_queue_is_empty(sim->event_queue)) {
+        return;
+    }
+
+    /* Recording, or replay checks made before the event changes any state */
+    if (sim->trace != NULL) {
+        Event* front = event_queue_peek(sim->event_queue);
+        if (front != NULL && !sim_trace_before_dispatch(sim, front)) {
+            sim->paused = true;
+            return;
+        }
+    }
+
     Event* event = event_queue_next(sim->event_queue);
     if (event == NULL) {
         return;
     }
+    sim->dispatched++;
+
+    /* Out-of-line payloads load while the clock is updated; inline ones are
+     * already on the event's first cache line */
+    if (event->data != (void*)event->payload) {
+        __builtin_prefetch(event->data);
+    }
 
     /* Advance clock to event time */
     SimTime time_advance = event->time - sim->clock->current_time;
-    if (time_advance > 0.0) {
+    if (time_advance > SIM_TIME_ZERO) {
         sim_clock_advance(sim->clock, time_advance);
         sim_stats_record_idle_time(sim->stats, time_advance);
     }
 
     /* Execute event handler */
-    if (event->handler != NULL) {
-        event->handler(event);
-    }
+    simulator_invoke(sim, event);
 
     /* Update statistics */
     sim->stats->total_time = sim->clock->current_time;
 
-    event_destroy(event);
+    if (!event->retained) {
+        event_destroy(event);
+    }
+}
+
+void simulator_step(Simulator* sim) {
+    if (sim == NULL) {
+        return;
+    }
+
+    Simulator* previous = simulator_set_current(sim);
+    simulator_dispatch(sim);
+    simulator_set_current(previous);
 }
 
 void simulator_pause(Simulator* sim) {
@@ -320,21 +833,133 @@ bool simulator_is_running(Simulator* sim) {
     return sim != NULL && sim->clock->running && !sim->paused;
 }
 
+Simulator* simulator_set_current(Simulator* sim) {
+    Simulator* previous = current_simulator;
+    current_simulator = sim;
+    return previous;
+}
+
+Simulator* simulator_current(void) {
+    return current_simulator;
+}
+
+/* Handler registry */
+static uint32_t handler_slot(EventHandler handler) {
+    uint64_t hash = (uint64_t)(uintptr_t)handler * UINT64_C(0x9e3779b97f4a7c15);
+    return (uint32_t)(hash >> 32) & (handler_slot_count - 1);
+}
+
+static bool handler_rehash(uint32_t slot_count) {
+    uint32_t* slots = (uint32_t*)calloc(slot_count, sizeof(uint32_t));
+    if (slots == NULL) {
+        return false;
+    }
+
+    free(handler_slots);
+    handler_slots = slots;
+    handler_slot_count = slot_count;
+    for (uint32_t id = 1; id < handler_count; id++) {
+        uint32_t slot = handler_slot(handler_table[id]);
+        while (handler_slots[slot] != 0) {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+        handler_slots[slot] = id;
+    }
+    return true;
+}
+
+uint32_t event_handler_register(EventHandler handler) {
+    if (handler == NULL) {
+        return 0;
+    }
+
+    uint32_t id = event_handler_id(handler);
+    if (id != EVENT_HANDLER_UNREGISTERED) {
+        return id;
+    }
+
+    if (handler_count >= handler_capacity) {
+        uint32_t capacity = handler_capacity > 0 ? handler_capacity * 2 : HANDLER_REGISTRY_INITIAL;
+        EventHandler* table = (EventHandler*)realloc(handler_table, capacity * sizeof(EventHandler));
+        if (table == NULL) {
+            return EVENT_HANDLER_UNREGISTERED;
+        }
+        table[0] = NULL;
+        handler_table = table;
+        handler_capacity = capacity;
+    }
+    if ((handler_count + 1) * 2 > handler_slot_count &&
+        !handler_rehash(handler_slot_count > 0 ? handler_slot_count * 2 : HANDLER_REGISTRY_INITIAL * 2)) {
+        return EVENT_HANDLER_UNREGISTERED;
+    }
+
+    id = handler_count++;
+    handler_table[id] = handler;
+    uint32_t slot = handler_slot(handler);
+    while (handler_slots[slot] != 0) {
+        slot = (slot + 1) & (handler_slot_count - 1);
+    }
+    handler_slots[slot] = id;
+    return id;
+}
+
+uint32_t event_handler_id(EventHandler handler) {
+    if (handler == NULL) {
+        return 0;
+    }
+    if (handler_slot_count == 0) {
+        return EVENT_HANDLER_UNREGISTERED;
+    }
+
+    uint32_t slot = handler_slot(handler);
+    while (handler_slots[slot] != 0) {
+        if (handler_table[handler_slots[slot]] == handler) {
+            return handler_slots[slot];
+        }
+        slot = (slot + 1) & (handler_slot_count - 1);
+    }
+    return EVENT_HANDLER_UNREGISTERED;
+}
+
+EventHandler event_handler_get(uint32_t id) {
+    return (id > 0 && id < handler_count) ? handler_table[id] : NULL;
+}
+
 /* Utility functions */
 SimTime sim_time_now(void) {
-    return global_sim_time;
+    return (current_simulator != NULL) ? current_simulator->clock->current_time : SIM_TIME_ZERO;
 }
 
+/* Never moves the clock past a pending event, which dispatch would then
+ * run in its past */
 void sim_time_delay(SimTime delay) {
-    if (delay > 0.0) {
-        global_sim_time += delay;
+    if (delay > SIM_TIME_ZERO && current_simulator != NULL) {
+        SimClock* clock = current_simulator->clock;
+        Event* next = event_queue_peek(current_simulator->event_queue);
+        if (next != NULL && next->time - clock->current_time < delay) {
+            delay = next->time - clock->current_time;
+        }
+        sim_clock_advance(clock, delay);
     }
 }
 
+/* Exact in integer mode, where one resolution divides the other */
 uint64_t sim_time_to_microseconds(SimTime time) {
+#if !defined(SIM_TIME_INTEGER)
     return (uint64_t)(time * 1000000.0);
+#elif SIM_TIME_RESOLUTION >= 1000000
+    return (uint64_t)time / (SIM_TIME_RESOLUTION / 1000000);
+#else
+    return (uint64_t)time * (1000000 / SIM_TIME_RESOLUTION);
+#endif
 }
 
 SimTime sim_time_from_microseconds(uint64_t microseconds) {
+#if !defined(SIM_TIME_INTEGER)
     return (SimTime)microseconds / 1000000.0;
+#elif SIM_TIME_RESOLUTION >= 1000000
+    return (SimTime)(microseconds * (SIM_TIME_RESOLUTION / 1000000));
+#else
+    return (SimTime)(microseconds / (1000000 / SIM_TIME_RESOLUTION));
+#endif
 }
\ No newline at end of file
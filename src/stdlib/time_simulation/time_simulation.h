@@ -4,13 +4,55 @@
 extern "C" {
 #endif
 
+#include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* Time simulation module for SIMSCRIPT */
 
-/* Simulation time representation */
+/* Simulation time representation. With SIM_TIME_INTEGER, SimTime is a
+ * count of ticks, SIM_TIME_RESOLUTION per time unit (one time unit is one
+ * second for the microsecond conversions), so comparisons are integer
+ * compares and runs are reproducible bit for bit. Convert model values
+ * (e.g. sampled delays) with sim_time_from_double. */
+#ifdef SIM_TIME_INTEGER
+
+#ifndef SIM_TIME_RESOLUTION
+#define SIM_TIME_RESOLUTION 1000000
+#endif
+
+#if (SIM_TIME_RESOLUTION % 1000000 != 0) && (1000000 % SIM_TIME_RESOLUTION != 0)
+#error "SIM_TIME_RESOLUTION must divide or be a multiple of 1000000"
+#endif
+
+typedef int64_t SimTime;
+#define SIM_TIME_MAX INT64_MAX
+
+static inline SimTime sim_time_from_double(double time) {
+    return (SimTime)llround(time * (double)SIM_TIME_RESOLUTION);
+}
+
+static inline double sim_time_to_double(SimTime time) {
+    return (double)time / (double)SIM_TIME_RESOLUTION;
+}
+
+#else
+
 typedef double SimTime;
+#define SIM_TIME_MAX HUGE_VAL
+
+static inline SimTime sim_time_from_double(double time) {
+    return time;
+}
+
+static inline double sim_time_to_double(SimTime time) {
+    return time;
+}
+
+#endif
+
+#define SIM_TIME_ZERO ((SimTime)0)
 
 /* Event types */
 typedef enum {
@@ -20,50 +62,172 @@ typedef enum {
     EVENT_CUSTOM
 } EventType;
 
-/* Event structure */
+/* Payloads up to this size are copied into the event itself */
+#define EVENT_INLINE_PAYLOAD_SIZE 32
+
+/* Event structure. The fields read at dispatch and the inline payload fill
+ * the first cache line; queue bookkeeping follows. */
 typedef struct Event {
     SimTime time;              /* Event time */
     EventType type;            /* Event type */
     int event_id;              /* Unique event identifier */
-    void* data;                /* Event-specific data */
+    void* data;                /* Event-specific data (may point at payload) */
     void (*handler)(struct Event*); /* Event handler function */
-    struct Event* next;        /* Next event in queue */
+    uint64_t payload[EVENT_INLINE_PAYLOAD_SIZE / sizeof(uint64_t)]; /* Inline payload storage */
+    struct Event* next;        /* Next event in queue / next sibling in pairing heap */
+    struct Event* child;       /* First child in pairing heap */
+    struct Event* prev;        /* Left sibling or parent in pairing heap */
+    uint64_t sequence;         /* Insertion order, breaks ties between equal times */
+    uint32_t handle_index;     /* Slot in the owning queue's handle table */
+    uint32_t payload_size;     /* Bytes copied into data by the _with_payload constructors */
+    bool cancelled;            /* Tombstone: skipped and freed when it reaches the front */
+    bool in_batch;             /* Dequeued by event_queue_next_batch, handle still live */
+    bool retained;             /* Not freed after dispatch; owner calls event_destroy */
+    bool owns_data;            /* data is a private copy freed with the event */
+    struct EventPool* pool;    /* Owning pool, NULL for events from event_create */
+    void* context;             /* Scheduler bookkeeping (e.g. Time Warp message record) */
 } Event;
 
-/* Event queue (priority queue by time) */
+/* Stable reference to a scheduled event; stale once the event fires or is cancelled */
+typedef struct EventHandle {
+    uint32_t index;            /* Slot in the queue's handle table */
+    uint32_t generation;       /* Must match the slot's generation to be live */
+} EventHandle;
+
+#define EVENT_HANDLE_INVALID_INDEX UINT32_MAX
+
+/* Event queue engines */
+typedef enum {
+    EVENT_QUEUE_SORTED_LIST,      /* Sorted linked list, O(n) schedule */
+    EVENT_QUEUE_BINARY_HEAP,      /* Array-backed binary heap */
+    EVENT_QUEUE_QUATERNARY_HEAP,  /* Cache-aligned 4-ary heap */
+    EVENT_QUEUE_PAIRING_HEAP,     /* Pairing heap linked through the events */
+    EVENT_QUEUE_CALENDAR          /* Calendar queue, amortized O(1) with adaptive bucket width */
+} EventQueueEngine;
+
+#define EVENT_QUEUE_DEFAULT_ENGINE EVENT_QUEUE_QUATERNARY_HEAP
+
+/* Heap ordering key. Keys live in their own dense array, parallel to the
+ * event pointers, so sifting compares without touching the events. */
+typedef struct EventQueueKey {
+    SimTime time;
+    uint64_t sequence;
+} EventQueueKey;
+
+/* Handle table slot, recycled through a free list */
+typedef struct EventQueueSlot {
+    Event* event;
+    uint32_t generation;
+    uint32_t next_free;
+} EventQueueSlot;
+
+/* Event queue (priority queue by time, FIFO among equal times) */
 typedef struct EventQueue {
-    Event* head;
-    int count;
+    EventQueueEngine engine;
+    Event* head;               /* Sorted list head or pairing heap root */
+    EventQueueKey* keys;       /* Heap keys for the binary and 4-ary engines */
+    Event** events;            /* Heap events, parallel to keys */
+    void* key_storage;         /* Aligned allocation backing keys */
+    int capacity;
+    int count;                 /* Events stored by the engine, including tombstones */
+    int dead_count;            /* Cancelled events not yet removed */
+    uint64_t next_sequence;
+    int next_event_id;
+    EventQueueSlot* slots;
+    uint32_t slot_capacity;
+    uint32_t free_slot;
+    /* Calendar engine: buckets hold sorted lists linked through Event::next */
+    Event** buckets;
+    Event** bucket_tails;
+    int bucket_count;          /* Power of two */
+    SimTime bucket_width;
+    int64_t current_bucket;    /* Virtual bucket (time / width) being drained */
+    bool resize_enabled;
+#ifdef SIM_INSTRUMENT
+    uint64_t schedule_calls;   /* Pushes into the engine */
+    uint64_t schedule_steps;   /* Heap levels sifted or list nodes scanned by those pushes */
+#endif
 } EventQueue;
 
 /* Simulation clock */
 typedef struct SimClock {
     SimTime current_time;
+    SimTime start_time;
     SimTime end_time;
     bool running;
 } SimClock;
 
-/* Statistics collector */
+struct OutputStat;
+
+/* Statistics collector; outputs are model statistics (output_analysis.h)
+ * reported with the run, owned by the caller */
 typedef struct SimStats {
     int total_events;
     int processed_events;
     SimTime total_time;
     SimTime idle_time;
+    struct OutputStat** outputs;
+    int output_count;
+    int output_capacity;
 } SimStats;
 
-/* Event queue operations */
+/* Event queue operations. Cancelled events are tombstoned and freed by the
+ * queue later, so the caller must not touch them after cancelling.
+ * event_queue_next_batch pops every event due within window of the front
+ * event; batched events stay cancellable until passed to
+ * event_queue_complete, and come back with cancelled set otherwise.
+ * event_queue_schedule_with_key orders equal times by a caller-supplied key
+ * instead of insertion order, for schedulers that must not depend on
+ * arrival order. */
 EventQueue* event_queue_create(void);
+EventQueue* event_queue_create_with_engine(EventQueueEngine engine);
 void event_queue_destroy(EventQueue* queue);
 bool event_queue_is_empty(EventQueue* queue);
-void event_queue_schedule(EventQueue* queue, Event* event);
+int event_queue_size(EventQueue* queue);
+EventHandle event_queue_schedule(EventQueue* queue, Event* event);
+EventHandle event_queue_schedule_with_key(EventQueue* queue, Event* event, uint64_t sequence);
 Event* event_queue_next(EventQueue* queue);
 Event* event_queue_peek(EventQueue* queue);
+int event_queue_next_batch(EventQueue* queue, Event** batch, int max_events, SimTime window);
+void event_queue_complete(EventQueue* queue, Event* event);
 void event_queue_cancel(EventQueue* queue, int event_id);
+bool event_queue_cancel_handle(EventQueue* queue, EventHandle handle);
+Event* event_queue_lookup(EventQueue* queue, EventHandle handle);
+bool event_handle_is_valid(EventHandle handle);
+/* Visits every scheduled, uncancelled event in no particular order; the
+ * visitor must not schedule or cancel events */
+void event_queue_for_each(EventQueue* queue, void (*visit)(Event* event, void* context),
+                          void* context);
 
-/* Event creation and management */
+/* Event creation and management. event_create allocates from the heap, so
+ * the event may outlive any simulator; pooled events die with their pool. */
 Event* event_create(SimTime time, EventType type, void* data,
                    void (*handler)(Event*));
+Event* event_create_with_payload(SimTime time, EventType type,
+                                 const void* payload, size_t size,
+                                 void (*handler)(Event*));
 void event_destroy(Event* event);
+void event_retain(Event* event);
+
+/* Slab allocator for events: cache-line aligned slots recycled via a free list */
+typedef struct EventPool {
+    void** slabs;
+    int slab_count;
+    int slab_capacity;
+    int events_per_slab;
+    size_t slot_size;          /* sizeof(Event) rounded up to a cache line */
+    Event* free_list;          /* Recycled slots linked through Event::next */
+    size_t in_use;
+    size_t high_water;         /* Peak number of events alive at once */
+    uint64_t total_allocations;
+} EventPool;
+
+EventPool* event_pool_create(int events_per_slab);
+void event_pool_destroy(EventPool* pool);
+Event* event_pool_alloc(EventPool* pool);
+void event_pool_free(EventPool* pool, Event* event);
+size_t event_pool_in_use(EventPool* pool);
+size_t event_pool_high_water(EventPool* pool);
 
 /* Simulation clock operations */
 SimClock* sim_clock_create(SimTime start_time, SimTime end_time);
@@ -77,26 +241,117 @@ SimStats* sim_stats_create(void);
 void sim_stats_destroy(SimStats* stats);
 void sim_stats_record_event(SimStats* stats, EventType type);
 void sim_stats_record_idle_time(SimStats* stats, SimTime idle_time);
+bool sim_stats_add_output(SimStats* stats, struct OutputStat* output);
 void sim_stats_print(SimStats* stats);
 
+/* Time-weighted statistic of a piecewise-constant value (queue length,
+ * busy units): O(1) state, updated on every change. The _now forms read
+ * the bound clock, so queries after a run has returned still integrate up
+ * to the simulator's time. An unbound stat binds to the current
+ * simulator at its first _now update (starting at the clock's start time
+ * if nothing has accumulated yet); until then the _now forms read the
+ * current simulator's clock, 0 without one. Bindings to a simulator are
+ * dropped by simulator_destroy, after which the stat is unbound again. */
+struct Simulator;
+
+typedef struct TimeWeightedStat {
+    SimClock* clock;           /* Clock the _now forms read, NULL until bound */
+    struct Simulator* owner;   /* Simulator that unbinds it on destroy, NULL if none */
+    int owner_index;           /* Slot in owner->bound_stats */
+    double value;              /* Value held since last_time */
+    SimTime start_time;
+    SimTime last_time;
+    double area;               /* Integral of value over time */
+    double area_sq;            /* Integral of value squared */
+    double min;
+    double max;
+} TimeWeightedStat;
+
+void time_weighted_init(TimeWeightedStat* stat, SimTime time, double value);
+
+/* Read time from clock (which must outlive the stat's use) and restart at
+ * its current time, keeping the value */
+void time_weighted_bind(TimeWeightedStat* stat, SimClock* clock);
+/* Bind to sim's clock until either is unbound or sim is destroyed */
+void time_weighted_bind_simulator(TimeWeightedStat* stat, struct Simulator* sim);
+/* Drop any binding; call before freeing a stat bound to a live simulator */
+void time_weighted_unbind(TimeWeightedStat* stat);
+/* Restart at the bound clock's current time, keeping value and binding */
+void time_weighted_restart(TimeWeightedStat* stat);
+void time_weighted_set(TimeWeightedStat* stat, SimTime time, double value);
+void time_weighted_set_now(TimeWeightedStat* stat, double value);
+double time_weighted_mean(const TimeWeightedStat* stat, SimTime time);
+double time_weighted_variance(const TimeWeightedStat* stat, SimTime time);
+double time_weighted_mean_now(const TimeWeightedStat* stat);
+double time_weighted_min(const TimeWeightedStat* stat);
+double time_weighted_max(const TimeWeightedStat* stat);
+
+struct SimTrace;
+struct Process;
+struct SimInbox;
+struct SimCounters;
+
 /* Simulation runner */
 typedef struct Simulator {
     SimClock* clock;
     EventQueue* event_queue;
     SimStats* stats;
+    EventPool* event_pool;
+    struct SimTrace* trace;    /* Recording or replay trace, NULL when off */
+    struct Process* processes; /* Live processes (process.h) */
+    struct SimInbox* inbox;    /* Events injected by other threads (sim_inbox.h), NULL when off */
+    struct SimCounters* counters; /* Kernel counters (sim_counters.h), NULL unless SIM_INSTRUMENT */
+    TimeWeightedStat** bound_stats; /* Stats reading this clock, unbound on destroy */
+    int bound_stat_count;
+    int bound_stat_capacity;
+    uint64_t dispatched;       /* Events dispatched so far */
     bool paused;
 } Simulator;
 
 Simulator* simulator_create(SimTime start_time, SimTime end_time);
+Simulator* simulator_create_with_engine(SimTime start_time, SimTime end_time,
+                                        EventQueueEngine engine);
 void simulator_destroy(Simulator* sim);
-void simulator_schedule_event(Simulator* sim, Event* event);
+Event* simulator_create_event(Simulator* sim, SimTime time, EventType type,
+                              void* data, void (*handler)(Event*));
+Event* simulator_create_event_with_payload(Simulator* sim, SimTime time, EventType type,
+                                           const void* payload, size_t size,
+                                           void (*handler)(Event*));
+EventHandle simulator_schedule_event(Simulator* sim, Event* event);
+bool simulator_cancel_event(Simulator* sim, EventHandle handle);
 void simulator_run(Simulator* sim);
+void simulator_run_batched(Simulator* sim, SimTime window);
+/* Runs like simulator_run but stops early once every output attached to
+ * sim->stats has a confidence interval whose half-width is at most
+ * relative_precision times its steady-state mean; returns whether that
+ * happened before the end time, an empty queue or a pause */
+bool simulator_run_until_precision(Simulator* sim, double confidence,
+                                   double relative_precision);
 void simulator_step(Simulator* sim);
 void simulator_pause(Simulator* sim);
 void simulator_resume(Simulator* sim);
 bool simulator_is_running(Simulator* sim);
 
-/* Utility functions */
+/* Simulator whose clock sim_time_now reads on this thread. simulator_run,
+ * simulator_run_batched and simulator_step make their simulator current
+ * for the duration of the call; set_current returns the previous one. */
+Simulator* simulator_set_current(Simulator* sim);
+Simulator* simulator_current(void);
+
+/* Handler registry: stable ids for handler functions, so traces and
+ * checkpoints can refer to them across runs. Register at startup, before
+ * simulations run; id 0 is the NULL handler. */
+#define EVENT_HANDLER_UNREGISTERED UINT32_MAX
+
+typedef void (*EventHandler)(Event*);
+
+uint32_t event_handler_register(EventHandler handler);
+uint32_t event_handler_id(EventHandler handler);
+EventHandler event_handler_get(uint32_t id);
+
+/* Utility functions (relative to the current simulator; 0 without one).
+ * sim_time_delay advances the current clock by a positive delay, but no
+ * further than the next pending event. */
 SimTime sim_time_now(void);
 void sim_time_delay(SimTime delay);
 uint64_t sim_time_to_microseconds(SimTime time);
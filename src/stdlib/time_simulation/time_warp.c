@@ -0,0 +1,706 @@
+#include "time_warp.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TIME_WARP_DEFAULT_BATCH 1024
+#define TIME_WARP_CHUNK 32           /* Events per LP before visiting the next one */
+#define TIME_WARP_INITIAL_CAPACITY 16
+#define TIME_WARP_ORIGIN_SHIFT 40    /* Key = origin LP << 40 | origin send counter */
+#define TIME_WARP_MAX_PROCESSES (1 << 23)
+
+/* Shared by the sender (which may cancel it) and the receiver (which may
+ * have processed it); freed when the last reference is dropped */
+struct TimeWarpRecord {
+    atomic_int refs;
+    atomic_bool cancelled;
+    bool processed;            /* Receiver side only */
+    int target;
+    SimTime time;
+    uint64_t key;
+};
+
+typedef struct TimeWarpMessage {
+    struct TimeWarpRecord* record;
+    bool anti;
+    EventType type;
+    void (*handler)(Event*);
+    void* payload;
+    size_t payload_size;
+} TimeWarpMessage;
+
+/* Double-buffered so the owner processes messages without holding the lock */
+struct TimeWarpInbox {
+    pthread_mutex_t lock;
+    TimeWarpMessage* items;
+    int count;
+    int capacity;
+    TimeWarpMessage* spare;
+    int spare_capacity;
+};
+
+struct TimeWarpSync {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int waiting;
+    int parties;
+    uint64_t generation;
+    atomic_long in_flight;     /* Messages pushed but not yet handled */
+    atomic_bool failed;
+    bool quiet;
+    bool done;
+    bool released;             /* Pool size is final; helpers may start */
+    SimTime* worker_min;
+};
+
+typedef struct TimeWarpWorker {
+    TimeWarpSimulator* tw;
+    int worker_id;
+} TimeWarpWorker;
+
+static _Thread_local TimeWarpProcess* current_process = NULL;
+
+static void sync_wait(struct TimeWarpSync* sync) {
+    pthread_mutex_lock(&sync->mutex);
+    uint64_t generation = sync->generation;
+    if (++sync->waiting == sync->parties) {
+        sync->waiting = 0;
+        sync->generation++;
+        pthread_cond_broadcast(&sync->cond);
+    } else {
+        while (generation == sync->generation) {
+            pthread_cond_wait(&sync->cond, &sync->mutex);
+        }
+    }
+    pthread_mutex_unlock(&sync->mutex);
+}
+
+static void record_release(struct TimeWarpRecord* record) {
+    if (record != NULL && atomic_fetch_sub(&record->refs, 1) == 1) {
+        free(record);
+    }
+}
+
+static bool record_cancelled(Event* event) {
+    struct TimeWarpRecord* record = (struct TimeWarpRecord*)event->context;
+    return record != NULL && atomic_load(&record->cancelled);
+}
+
+static void discard_event(Event* event) {
+    record_release((struct TimeWarpRecord*)event->context);
+    event_destroy(event);
+}
+
+/* Total order on events: time, then origin LP and send counter */
+static bool key_before(SimTime time_a, uint64_t key_a, SimTime time_b, uint64_t key_b) {
+    return time_a < time_b || (time_a == time_b && key_a < key_b);
+}
+
+static bool grow_array(void** items, int* capacity, size_t item_size) {
+    int new_capacity = *capacity > 0 ? *capacity * 2 : TIME_WARP_INITIAL_CAPACITY;
+    void* grown = realloc(*items, (size_t)new_capacity * item_size);
+    if (grown == NULL) {
+        return false;
+    }
+    *items = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static bool inbox_push(TimeWarpSimulator* tw, TimeWarpProcess* target,
+                       const TimeWarpMessage* message) {
+    struct TimeWarpInbox* inbox = target->inbox;
+    pthread_mutex_lock(&inbox->lock);
+    if (inbox->count == inbox->capacity &&
+        !grow_array((void**)&inbox->items, &inbox->capacity, sizeof(TimeWarpMessage))) {
+        pthread_mutex_unlock(&inbox->lock);
+        return false;
+    }
+    inbox->items[inbox->count++] = *message;
+    atomic_fetch_add(&tw->sync->in_flight, 1);
+    pthread_mutex_unlock(&inbox->lock);
+    return true;
+}
+
+/* Undo log: old bytes followed by their (address, size) header, so entries
+ * are walked backwards from the end */
+static void log_restore(TimeWarpProcess* lp, size_t offset) {
+    while (lp->log_size > offset) {
+        void* address;
+        size_t size;
+        lp->log_size -= sizeof(void*) + sizeof(size_t);
+        memcpy(&address, lp->log + lp->log_size, sizeof(void*));
+        memcpy(&size, lp->log + lp->log_size + sizeof(void*), sizeof(size_t));
+        lp->log_size -= size;
+        memcpy(address, lp->log + lp->log_size, size);
+    }
+}
+
+/* Sender side of a cancellation; remote targets get an anti-message, local
+ * events are dropped when they reach the front of the queue */
+static void cancel_record(TimeWarpProcess* lp, struct TimeWarpRecord* record) {
+    atomic_store(&record->cancelled, true);
+    if (record->target != lp->id) {
+        TimeWarpMessage anti = {record, true, 0, NULL, NULL, 0};
+        atomic_fetch_add(&record->refs, 1);
+        if (!inbox_push(lp->owner, &lp->owner->processes[record->target], &anti)) {
+            /* The target drops the event lazily, but cannot undo it if processed */
+            atomic_store(&lp->owner->sync->failed, true);
+            record_release(record);
+        }
+    }
+    record_release(record);
+}
+
+/* Undoes every processed event at or after (time, key), newest first */
+static void rollback(TimeWarpProcess* lp, SimTime time, uint64_t key) {
+    int undone = 0;
+    while (lp->processed_count > 0) {
+        TimeWarpProcessed* entry = &lp->processed[lp->processed_count - 1];
+        Event* event = entry->event;
+        if (key_before(event->time, event->sequence, time, key)) {
+            break;
+        }
+
+        log_restore(lp, entry->log_offset);
+        for (int i = entry->sent_begin; i < lp->sent_count; i++) {
+            cancel_record(lp, lp->sent[i]);
+        }
+        lp->sent_count = entry->sent_begin;
+        lp->counter = entry->counter;
+        lp->sim->clock->current_time = entry->clock;
+        lp->processed_count--;
+        undone++;
+
+        struct TimeWarpRecord* record = (struct TimeWarpRecord*)event->context;
+        if (record != NULL) {
+            record->processed = false;
+        }
+        if (record_cancelled(event)) {
+            discard_event(event);
+        } else {
+            event_queue_schedule_with_key(lp->sim->event_queue, event, event->sequence);
+        }
+    }
+
+    if (undone > 0) {
+        lp->rollbacks++;
+        lp->rolled_back_events += (uint64_t)undone;
+    }
+}
+
+static void receive_message(TimeWarpProcess* lp, TimeWarpMessage* message) {
+    struct TimeWarpRecord* record = message->record;
+
+    if (message->anti) {
+        if (record->processed) {
+            rollback(lp, record->time, record->key);
+        }
+        record_release(record);
+        return;
+    }
+
+    if (atomic_load(&record->cancelled)) {
+        free(message->payload);
+        record_release(record);
+        return;
+    }
+
+    Event* event = simulator_create_event_with_payload(lp->sim, record->time, message->type,
+                                                       message->payload,
+                                                       message->payload_size,
+                                                       message->handler);
+    free(message->payload);
+    if (event == NULL) {
+        atomic_store(&lp->owner->sync->failed, true);
+        record_release(record);
+        return;
+    }
+    event->context = record;
+
+    /* Straggler: arrives in the LP's past */
+    if (lp->processed_count > 0) {
+        Event* last = lp->processed[lp->processed_count - 1].event;
+        if (key_before(record->time, record->key, last->time, last->sequence)) {
+            rollback(lp, record->time, record->key);
+        }
+    }
+    event_queue_schedule_with_key(lp->sim->event_queue, event, record->key);
+}
+
+static void drain_inbox(TimeWarpSimulator* tw, TimeWarpProcess* lp) {
+    struct TimeWarpInbox* inbox = lp->inbox;
+
+    pthread_mutex_lock(&inbox->lock);
+    TimeWarpMessage* items = inbox->items;
+    int count = inbox->count;
+    int capacity = inbox->capacity;
+    inbox->items = inbox->spare;
+    inbox->capacity = inbox->spare_capacity;
+    inbox->count = 0;
+    inbox->spare = items;
+    inbox->spare_capacity = capacity;
+    pthread_mutex_unlock(&inbox->lock);
+
+    for (int i = 0; i < count; i++) {
+        receive_message(lp, &items[i]);
+    }
+    /* Only after any anti-messages caused by these have been counted */
+    if (count > 0) {
+        atomic_fetch_sub(&tw->sync->in_flight, count);
+    }
+}
+
+static Event* front_event(TimeWarpProcess* lp) {
+    EventQueue* queue = lp->sim->event_queue;
+    Event* event;
+    while ((event = event_queue_peek(queue)) != NULL && record_cancelled(event)) {
+        event_queue_next(queue);
+        discard_event(event);
+    }
+    return event;
+}
+
+static bool process_next(TimeWarpProcess* lp, SimTime limit) {
+    Event* event = front_event(lp);
+    if (event == NULL || event->time >= limit) {
+        return false;
+    }
+
+    if (lp->processed_count == lp->processed_capacity &&
+        !grow_array((void**)&lp->processed, &lp->processed_capacity,
+                    sizeof(TimeWarpProcessed))) {
+        atomic_store(&lp->owner->sync->failed, true);
+        return false;
+    }
+
+    event_queue_next(lp->sim->event_queue);
+    SimClock* clock = lp->sim->clock;
+    TimeWarpProcessed* entry = &lp->processed[lp->processed_count++];
+    entry->event = event;
+    entry->clock = clock->current_time;
+    entry->log_offset = lp->log_size;
+    entry->counter = lp->counter;
+    entry->sent_begin = lp->sent_count;
+
+    sim_clock_advance(clock, event->time - clock->current_time);
+    if (event->context != NULL) {
+        ((struct TimeWarpRecord*)event->context)->processed = true;
+    }
+    if (event->handler != NULL) {
+        event->handler(event);
+    }
+    return true;
+}
+
+/* Commits history older than gvt and reclaims its undo information */
+static void fossil_collect(TimeWarpProcess* lp, SimTime gvt) {
+    int committed = 0;
+    while (committed < lp->processed_count && lp->processed[committed].event->time < gvt) {
+        Event* event = lp->processed[committed].event;
+        if (lp->commit != NULL) {
+            lp->commit(lp, event);
+        }
+        discard_event(event);
+        committed++;
+    }
+
+    if (committed == 0) {
+        return;
+    }
+
+    size_t log_keep = 0;
+    int sent_keep = lp->sent_count;
+    if (committed < lp->processed_count) {
+        log_keep = lp->processed[committed].log_offset;
+        sent_keep = lp->processed[committed].sent_begin;
+    } else {
+        log_keep = lp->log_size;
+    }
+
+    for (int i = 0; i < sent_keep; i++) {
+        record_release(lp->sent[i]);
+    }
+    memmove(lp->sent, lp->sent + sent_keep,
+            (size_t)(lp->sent_count - sent_keep) * sizeof(struct TimeWarpRecord*));
+    lp->sent_count -= sent_keep;
+
+    memmove(lp->log, lp->log + log_keep, lp->log_size - log_keep);
+    lp->log_size -= log_keep;
+
+    memmove(lp->processed, lp->processed + committed,
+            (size_t)(lp->processed_count - committed) * sizeof(TimeWarpProcessed));
+    lp->processed_count -= committed;
+    for (int i = 0; i < lp->processed_count; i++) {
+        lp->processed[i].log_offset -= log_keep;
+        lp->processed[i].sent_begin -= sent_keep;
+    }
+
+    lp->committed_events += (uint64_t)committed;
+}
+
+static void optimistic_phase(TimeWarpSimulator* tw, int worker_id) {
+    SimTime limit = tw->end_time;
+    if (tw->optimism_window > SIM_TIME_ZERO && tw->gvt + tw->optimism_window < limit) {
+        limit = tw->gvt + tw->optimism_window;
+    }
+
+    int processed = 0;
+    bool progress = true;
+    while (progress && processed < tw->batch_size && !atomic_load(&tw->sync->failed)) {
+        progress = false;
+        for (int i = worker_id; i < tw->process_count; i += tw->thread_count) {
+            TimeWarpProcess* lp = &tw->processes[i];
+            drain_inbox(tw, lp);
+            current_process = lp;
+            simulator_set_current(lp->sim);
+            for (int n = 0; n < TIME_WARP_CHUNK && process_next(lp, limit); n++) {
+                processed++;
+                progress = true;
+            }
+            current_process = NULL;
+            simulator_set_current(NULL);
+        }
+    }
+}
+
+/* Synchronous GVT: deliver everything in flight (including anti-messages
+ * caused by the resulting rollbacks), then take the earliest pending time */
+static void gvt_phase(TimeWarpSimulator* tw, int worker_id) {
+    struct TimeWarpSync* sync = tw->sync;
+
+    sync_wait(sync);
+    do {
+        for (int i = worker_id; i < tw->process_count; i += tw->thread_count) {
+            drain_inbox(tw, &tw->processes[i]);
+        }
+        sync_wait(sync);
+        if (worker_id == 0) {
+            sync->quiet = atomic_load(&sync->in_flight) == 0;
+        }
+        sync_wait(sync);
+    } while (!sync->quiet);
+
+    SimTime local_min = SIM_TIME_MAX;
+    for (int i = worker_id; i < tw->process_count; i += tw->thread_count) {
+        Event* front = front_event(&tw->processes[i]);
+        if (front != NULL && front->time < local_min) {
+            local_min = front->time;
+        }
+    }
+    sync->worker_min[worker_id] = local_min;
+    sync_wait(sync);
+
+    if (worker_id == 0) {
+        SimTime gvt = SIM_TIME_MAX;
+        for (int w = 0; w < tw->thread_count; w++) {
+            if (sync->worker_min[w] < gvt) {
+                gvt = sync->worker_min[w];
+            }
+        }
+        sync->done = gvt >= tw->end_time || atomic_load(&sync->failed);
+        tw->gvt = gvt < tw->end_time ? gvt : tw->end_time;
+        tw->gvt_rounds++;
+    }
+    sync_wait(sync);
+}
+
+static void* worker_main(void* arg) {
+    TimeWarpWorker* worker = (TimeWarpWorker*)arg;
+    TimeWarpSimulator* tw = worker->tw;
+
+    /* thread_count sets the LP stride, so it must not change once any
+     * worker steps an LP */
+    pthread_mutex_lock(&tw->sync->mutex);
+    while (!tw->sync->released) {
+        pthread_cond_wait(&tw->sync->cond, &tw->sync->mutex);
+    }
+    pthread_mutex_unlock(&tw->sync->mutex);
+
+    while (1) {
+        optimistic_phase(tw, worker->worker_id);
+        gvt_phase(tw, worker->worker_id);
+
+        for (int i = worker->worker_id; i < tw->process_count; i += tw->thread_count) {
+            fossil_collect(&tw->processes[i], tw->gvt);
+        }
+        if (tw->sync->done) {
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+TimeWarpSimulator* time_warp_create(int process_count, int thread_count,
+                                    SimTime start_time, SimTime end_time) {
+    if (process_count <= 0 || process_count > TIME_WARP_MAX_PROCESSES) {
+        return NULL;
+    }
+
+    TimeWarpSimulator* tw = (TimeWarpSimulator*)malloc(sizeof(TimeWarpSimulator));
+    if (tw == NULL) {
+        return NULL;
+    }
+
+    tw->processes = (TimeWarpProcess*)calloc((size_t)process_count, sizeof(TimeWarpProcess));
+    tw->sync = (struct TimeWarpSync*)calloc(1, sizeof(struct TimeWarpSync));
+    tw->process_count = process_count;
+    tw->thread_count = thread_count > 0 ? thread_count : 1;
+    if (tw->thread_count > process_count) {
+        tw->thread_count = process_count;
+    }
+    tw->end_time = end_time;
+    tw->gvt = start_time;
+    tw->optimism_window = SIM_TIME_ZERO;
+    tw->batch_size = TIME_WARP_DEFAULT_BATCH;
+    tw->gvt_rounds = 0;
+
+    if (tw->processes == NULL || tw->sync == NULL) {
+        free(tw->sync);
+        tw->sync = NULL;
+        time_warp_destroy(tw);
+        return NULL;
+    }
+
+    pthread_mutex_init(&tw->sync->mutex, NULL);
+    pthread_cond_init(&tw->sync->cond, NULL);
+    tw->sync->parties = tw->thread_count;
+    tw->sync->released = false;
+    atomic_init(&tw->sync->in_flight, 0);
+    atomic_init(&tw->sync->failed, false);
+    tw->sync->worker_min = (SimTime*)malloc((size_t)tw->thread_count * sizeof(SimTime));
+    if (tw->sync->worker_min == NULL) {
+        time_warp_destroy(tw);
+        return NULL;
+    }
+
+    for (int i = 0; i < process_count; i++) {
+        TimeWarpProcess* lp = &tw->processes[i];
+        lp->id = i;
+        lp->owner = tw;
+        lp->sim = simulator_create(start_time, end_time);
+        lp->inbox = (struct TimeWarpInbox*)calloc(1, sizeof(struct TimeWarpInbox));
+        if (lp->sim == NULL || lp->inbox == NULL) {
+            time_warp_destroy(tw);
+            return NULL;
+        }
+        pthread_mutex_init(&lp->inbox->lock, NULL);
+    }
+
+    return tw;
+}
+
+void time_warp_destroy(TimeWarpSimulator* tw) {
+    if (tw == NULL) {
+        return;
+    }
+
+    if (tw->processes != NULL) {
+        for (int i = 0; i < tw->process_count; i++) {
+            TimeWarpProcess* lp = &tw->processes[i];
+            if (lp->inbox != NULL) {
+                for (int m = 0; m < lp->inbox->count; m++) {
+                    free(lp->inbox->items[m].payload);
+                    record_release(lp->inbox->items[m].record);
+                }
+                pthread_mutex_destroy(&lp->inbox->lock);
+                free(lp->inbox->items);
+                free(lp->inbox->spare);
+                free(lp->inbox);
+            }
+            for (int p = 0; p < lp->processed_count; p++) {
+                discard_event(lp->processed[p].event);
+            }
+            for (int s = 0; s < lp->sent_count; s++) {
+                record_release(lp->sent[s]);
+            }
+            if (lp->sim != NULL) {
+                /* Pending events hold message records the queue does not know about */
+                Event* event;
+                while ((event = event_queue_next(lp->sim->event_queue)) != NULL) {
+                    discard_event(event);
+                }
+                simulator_destroy(lp->sim);
+            }
+            free(lp->processed);
+            free(lp->sent);
+            free(lp->log);
+        }
+        free(tw->processes);
+    }
+
+    if (tw->sync != NULL) {
+        pthread_mutex_destroy(&tw->sync->mutex);
+        pthread_cond_destroy(&tw->sync->cond);
+        free(tw->sync->worker_min);
+        free(tw->sync);
+    }
+    free(tw);
+}
+
+TimeWarpProcess* time_warp_get_process(TimeWarpSimulator* tw, int id) {
+    if (tw == NULL || id < 0 || id >= tw->process_count) {
+        return NULL;
+    }
+    return &tw->processes[id];
+}
+
+int time_warp_run(TimeWarpSimulator* tw) {
+    if (tw == NULL) {
+        return -1;
+    }
+
+    int helpers = tw->thread_count - 1;
+    pthread_t* threads = NULL;
+    TimeWarpWorker* workers = (TimeWarpWorker*)malloc((size_t)tw->thread_count *
+                                                      sizeof(TimeWarpWorker));
+    if (helpers > 0) {
+        threads = (pthread_t*)malloc((size_t)helpers * sizeof(pthread_t));
+    }
+    if (workers == NULL || (helpers > 0 && threads == NULL)) {
+        free(workers);
+        free(threads);
+        return -1;
+    }
+
+    if (tw->batch_size <= 0) {
+        tw->batch_size = TIME_WARP_DEFAULT_BATCH;
+    }
+    tw->sync->done = false;
+    tw->sync->released = false;
+    tw->sync->parties = tw->thread_count;
+    for (int i = 0; i < tw->thread_count; i++) {
+        workers[i].tw = tw;
+        workers[i].worker_id = i;
+    }
+
+    /* Run with fewer threads if the pool cannot be fully started */
+    int started = 0;
+    for (int i = 0; i < helpers; i++) {
+        if (pthread_create(&threads[i], NULL, worker_main, &workers[i + 1]) != 0) {
+            break;
+        }
+        started++;
+    }
+    /* Helpers wait at the start gate, so the pool can still shrink */
+    pthread_mutex_lock(&tw->sync->mutex);
+    if (started < helpers) {
+        tw->thread_count = started + 1;
+        tw->sync->parties = started + 1;
+        helpers = started;
+    }
+    tw->sync->released = true;
+    pthread_cond_broadcast(&tw->sync->cond);
+    pthread_mutex_unlock(&tw->sync->mutex);
+
+    worker_main(&workers[0]);
+
+    for (int i = 0; i < helpers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(workers);
+    free(threads);
+    return atomic_load(&tw->sync->failed) ? -1 : 0;
+}
+
+TimeWarpProcess* time_warp_current(void) {
+    return current_process;
+}
+
+SimTime time_warp_now(TimeWarpProcess* lp) {
+    return (lp != NULL) ? sim_clock_get_time(lp->sim->clock) : SIM_TIME_ZERO;
+}
+
+bool time_warp_save(TimeWarpProcess* lp, void* address, size_t size) {
+    if (lp == NULL || address == NULL) {
+        return false;
+    }
+    if (current_process != lp || size == 0) {
+        return true;  /* Outside a handler there is nothing to undo */
+    }
+
+    size_t needed = lp->log_size + size + sizeof(void*) + sizeof(size_t);
+    if (needed > lp->log_capacity) {
+        size_t new_capacity = lp->log_capacity > 0 ? lp->log_capacity : 256;
+        while (new_capacity < needed) {
+            new_capacity *= 2;
+        }
+        unsigned char* log = (unsigned char*)realloc(lp->log, new_capacity);
+        if (log == NULL) {
+            return false;
+        }
+        lp->log = log;
+        lp->log_capacity = new_capacity;
+    }
+
+    memcpy(lp->log + lp->log_size, address, size);
+    lp->log_size += size;
+    memcpy(lp->log + lp->log_size, &address, sizeof(void*));
+    memcpy(lp->log + lp->log_size + sizeof(void*), &size, sizeof(size_t));
+    lp->log_size += sizeof(void*) + sizeof(size_t);
+    return true;
+}
+
+bool time_warp_send(TimeWarpProcess* lp, int target, SimTime time, EventType type,
+                    const void* payload, size_t size, void (*handler)(Event*)) {
+    if (lp == NULL || lp->owner == NULL || target < 0 || target >= lp->owner->process_count) {
+        return false;
+    }
+
+    SimTime now = sim_clock_get_time(lp->sim->clock);
+    if (time < now || (current_process == lp && time == now)) {
+        return false;
+    }
+
+    if (lp->sent_count == lp->sent_capacity &&
+        !grow_array((void**)&lp->sent, &lp->sent_capacity, sizeof(struct TimeWarpRecord*))) {
+        return false;
+    }
+
+    struct TimeWarpRecord* record = (struct TimeWarpRecord*)malloc(sizeof(struct TimeWarpRecord));
+    if (record == NULL) {
+        return false;
+    }
+    atomic_init(&record->refs, 2);  /* Sender history and the event */
+    atomic_init(&record->cancelled, false);
+    record->processed = false;
+    record->target = target;
+    record->time = time;
+    record->key = ((uint64_t)lp->id << TIME_WARP_ORIGIN_SHIFT) |
+                  (lp->counter & ((UINT64_C(1) << TIME_WARP_ORIGIN_SHIFT) - 1));
+
+    if (target == lp->id) {
+        Event* event = simulator_create_event_with_payload(lp->sim, time, type, payload,
+                                                           size, handler);
+        if (event == NULL) {
+            free(record);
+            return false;
+        }
+        event->context = record;
+        event_queue_schedule_with_key(lp->sim->event_queue, event, record->key);
+    } else {
+        void* copy = NULL;
+        if (payload != NULL && size > 0) {
+            copy = malloc(size);
+            if (copy == NULL) {
+                free(record);
+                return false;
+            }
+            memcpy(copy, payload, size);
+        }
+
+        TimeWarpMessage message = {record, false, type, handler, copy, copy != NULL ? size : 0};
+        if (!inbox_push(lp->owner, &lp->owner->processes[target], &message)) {
+            free(copy);
+            free(record);
+            return false;
+        }
+    }
+
+    lp->sent[lp->sent_count++] = record;
+    lp->counter++;
+    return true;
+}
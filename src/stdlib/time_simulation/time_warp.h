@@ -0,0 +1,110 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "time_simulation.h"
+
+/* Optimistic (Time Warp) parallel simulation for SIMSCRIPT.
+ *
+ * Logical processes execute events speculatively without waiting for each
+ * other. A message arriving in an LP's past (a straggler) rolls the LP back:
+ * state is restored from an incremental undo log, messages sent by the undone
+ * events are cancelled with anti-messages, and the events are re-queued.
+ * Global virtual time (GVT) is computed at synchronous checkpoints; history
+ * older than GVT is committed and reclaimed (fossil collection).
+ *
+ * Events are ordered by (time, origin LP, origin send counter), so committed
+ * results do not depend on the thread count or on message arrival order.
+ * Handlers must call time_warp_save before modifying any LP state, and must
+ * not have side effects outside it; the commit callback runs exactly once
+ * per committed event, on the worker that owns the LP. */
+
+struct TimeWarpSimulator;
+struct TimeWarpSync;
+struct TimeWarpRecord;
+struct TimeWarpInbox;
+
+/* Event executed but not yet committed */
+typedef struct TimeWarpProcessed {
+    Event* event;
+    SimTime clock;             /* LP time before the event ran */
+    size_t log_offset;         /* Undo log size before the event ran */
+    uint64_t counter;          /* Send counter before the event ran */
+    int sent_begin;            /* First entry in sent made by this event */
+} TimeWarpProcessed;
+
+/* Logical process */
+typedef struct TimeWarpProcess {
+    int id;
+    Simulator* sim;            /* Pending events, clock and event pool */
+    void* state;               /* User state */
+    void (*commit)(struct TimeWarpProcess* lp, Event* event); /* Optional, runs once per committed event */
+    struct TimeWarpSimulator* owner;
+    uint64_t counter;          /* Messages and events created so far */
+
+    TimeWarpProcessed* processed;
+    int processed_count;
+    int processed_capacity;
+
+    struct TimeWarpRecord** sent;
+    int sent_count;
+    int sent_capacity;
+
+    unsigned char* log;        /* Undo log: [old bytes][address, size] entries */
+    size_t log_size;
+    size_t log_capacity;
+
+    struct TimeWarpInbox* inbox; /* Messages and anti-messages from other LPs */
+
+    uint64_t committed_events;
+    uint64_t rolled_back_events;
+    uint64_t rollbacks;
+} TimeWarpProcess;
+
+/* Optimistic parallel simulator */
+typedef struct TimeWarpSimulator {
+    TimeWarpProcess* processes;
+    int process_count;
+    int thread_count;
+    SimTime end_time;
+    SimTime gvt;               /* Global virtual time at the last checkpoint */
+    SimTime optimism_window;   /* Events beyond gvt + window wait for the next checkpoint (0 = unbounded) */
+    int batch_size;            /* Events per worker between GVT checkpoints */
+    uint64_t gvt_rounds;
+    struct TimeWarpSync* sync;
+} TimeWarpSimulator;
+
+/* Create an optimistic simulator with process_count LPs */
+TimeWarpSimulator* time_warp_create(int process_count, int thread_count,
+                                    SimTime start_time, SimTime end_time);
+
+/* Destroy the simulator and all logical processes */
+void time_warp_destroy(TimeWarpSimulator* tw);
+
+/* Get logical process by id */
+TimeWarpProcess* time_warp_get_process(TimeWarpSimulator* tw, int id);
+
+/* Run until GVT reaches end_time (returns 0 on success) */
+int time_warp_run(TimeWarpSimulator* tw);
+
+/* Logical process whose handler is running on this thread */
+TimeWarpProcess* time_warp_current(void);
+
+/* Current simulation time of a logical process */
+SimTime time_warp_now(TimeWarpProcess* lp);
+
+/* Record the current contents of [address, address + size) so a rollback
+ * can restore them; call before modifying LP state in a handler */
+bool time_warp_save(TimeWarpProcess* lp, void* address, size_t size);
+
+/* Schedule an event (local when target == lp->id); the payload is copied.
+ * From a handler, time must be later than the sender's current time so the
+ * new event cannot precede its cause; before the run it may equal it. */
+bool time_warp_send(TimeWarpProcess* lp, int target, SimTime time, EventType type,
+                    const void* payload, size_t size, void (*handler)(Event*));
+
+#ifdef __cplusplus
+}
+#endif